@@ -16,14 +16,50 @@
 #ifndef cluster_manager_h_
 #define cluster_manager_h_
 
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/timer.h>
+#include <deal.II/grid/cell_id.h>
 #include <deal.II/distributed/tria.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/lac/la_parallel_vector.h>
 
+#include <bitset>
+#include <cstdint>
+#include <map>
+
 namespace HDG_WE
 {
   using namespace dealii;
 
+  // dense array of flags, one bit per cell
+  class CellFlags
+  {
+  public:
+    // n cleared flags
+    void reinit(const unsigned int n)
+    {
+      words.assign((n+63)/64,0);
+    }
+
+    bool operator[](const unsigned int i) const
+    {
+      return (words[i/64] >> (i%64)) & 1;
+    }
+
+    void set(const unsigned int i)
+    {
+      words[i/64] |= std::uint64_t(1) << (i%64);
+    }
+
+    void reset(const unsigned int i)
+    {
+      words[i/64] &= ~(std::uint64_t(1) << (i%64));
+    }
+
+  private:
+    std::vector<std::uint64_t> words;
+  };
+
   template <typename Number>
   class ClusterManager
   {
@@ -32,13 +68,35 @@ namespace HDG_WE
     static const unsigned int n_vect = VectorizedArray<Number>::n_array_elements;
 
     ClusterManager(const double rel_tol=1.e-4)
-      :relative_tolerance(rel_tol)
+      :costs_are_measured(false),
+       step_time(0.),
+       relative_tolerance(rel_tol),
+       use_ader_post(false),
+       optimize_clusters(false),
+       relative_interface_cost(0.5),
+       relative_reconstruction_cost(1.),
+       nested_time_steps(false),
+       n_flux_memory_batches(0),
+       ghost_clusters_begin(0),
+       ghost_clusters_end(0),
+       repartition_threshold(0.),
+       previous_fastest_time_step(0.),
+       previous_n_levels(0),
+       optimized_n_clusters(0)
     {}
 
     template <typename Operator> void perform_time_step(const Operator &op,
                                                         const LinearAlgebra::distributed::Vector<Number>  &src,
                                                         LinearAlgebra::distributed::Vector<Number>        &dst) const;
 
+    // advance the state in place by one global time step of the low-storage
+    // Runge-Kutta scheme with the factors a_{i+1,i} and weights b_i of its
+    // two-register form, each cluster with its own time step
+    template <typename Operator> void perform_multirate_time_step(const Operator &op,
+                                                                  const std::vector<double> &stage_factors,
+                                                                  const std::vector<double> &weights,
+                                                                  LinearAlgebra::distributed::Vector<Number> &state) const;
+
     template <int dim> void propose_cluster_categorization(std::vector<unsigned int> &categories,
                                                            const Triangulation<dim> &tria,
                                                            const std::vector<const DoFHandler<dim> *> &dof_handlers,
@@ -46,20 +104,56 @@ namespace HDG_WE
                                                            const unsigned int max_diff,
                                                            const double cfl_number);
 
+    // let iterate_cluster_categorization choose the number of clusters and
+    // the time step difference from a cost model, bounded by its limits. The
+    // costs of the extra first ader step of interface cells and of the
+    // reconstruction are given relative to the update of a cell.
+    void enable_cluster_optimization(const bool   with_ader_post,
+                                     const double interface_cost,
+                                     const double reconstruction_cost)
+    {
+      optimize_clusters = true;
+      use_ader_post = with_ader_post;
+      relative_interface_cost = interface_cost;
+      relative_reconstruction_cost = reconstruction_cost;
+    }
+
+    // let the time step of cluster c be 2^c times the fastest time step, such
+    // that a cluster step spans a whole number of steps of the faster cluster
+    // as required by perform_multirate_time_step
+    void enable_nested_time_steps()
+    {
+      nested_time_steps = true;
+    }
+
+    // skip the repartitioning by cluster weights if the heaviest rank
+    // exceeds the average weight by at most this fraction
+    void set_repartition_threshold(const double threshold)
+    {
+      repartition_threshold = threshold;
+    }
+
     template <int dim> void iterate_cluster_categorization(const Triangulation<dim> &tria,
                                                            const std::vector<const DoFHandler<dim> *> &dof_handlers,
                                                            const unsigned int max_clusters,
                                                            const unsigned int max_diff,
                                                            const double cfl_number);
 
-    template <int dim> unsigned int cell_weight(const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
-                                                const typename parallel::distributed::Triangulation<dim>::CellStatus status)
+    ~ClusterManager()
     {
-      const unsigned int cell_weight = element_categories[cell->active_cell_index()]/3;
-
-      return cell_weight;
+      weight_connection.disconnect();
     }
 
+    // weight of a cell for the partitioning on top of the default weight 1000,
+    // proportional to the cost of the cell per global time step
+    template <int dim> unsigned int cell_weight(const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+                                                const typename parallel::distributed::Triangulation<dim>::CellStatus status) const;
+
+    // relative excess of the slowest rank over the average time spent in
+    // perform_time_step since the last setup, also updates the cell costs
+    // with the measured timings. Must be called on all ranks.
+    double load_imbalance() const;
+
     template <typename Operator> void setup(const Operator &op);
 
     template <typename Operator> void setup_mf_index_to_cell_index(const Operator &op);
@@ -124,6 +218,55 @@ namespace HDG_WE
     {
       return phi_neighbor_to_fluxmemory[face];
     }
+
+    // cells flagged by is_evaluate_cell, in the order they were flagged
+    const std::vector<unsigned int> &get_evaluate_cells() const
+    {
+      return evaluate_cell_list;
+    }
+
+    // contiguous ranges of the inner and boundary face batches that contain
+    // all faces of the cluster being evaluated
+    std::pair<unsigned int,unsigned int> get_inner_face_range() const
+    {
+      return cluster_inner_face_ranges[evaluated_cluster];
+    }
+
+    std::pair<unsigned int,unsigned int> get_boundary_face_range() const
+    {
+      return cluster_boundary_face_ranges[evaluated_cluster];
+    }
+
+    // cells flagged by is_update_cell, in the order they were flagged
+    const std::vector<unsigned int> &get_update_cells() const
+    {
+      return update_cell_list;
+    }
+
+    // position of a cell batch in the compact flux memory, which only holds
+    // the cell batches next to a cluster interface (invalid_unsigned_int for
+    // all others)
+    unsigned int get_flux_memory_index(unsigned int cell) const
+    {
+      return flux_memory_index[cell];
+    }
+
+    unsigned int n_flux_memory_cells() const
+    {
+      return n_flux_memory_batches;
+    }
+
+    // add the flux memory of the interface ghost cells to their owners and
+    // zero it on the ghosts
+    void exchange_flux_memory(AlignedVector<VectorizedArray<Number> > &flux_memory,
+                              const unsigned int                        dofs_per_cell) const;
+
+    // ghost exchange restricted to the cells of the clusters next to the one
+    // currently evaluated, replacing update_ghost_values() and
+    // compress(VectorOperation::add) of the full vector
+    void update_ghost_values(const LinearAlgebra::distributed::Vector<Number> &vec) const;
+
+    void compress_add(LinearAlgebra::distributed::Vector<Number> &vec) const;
     //}
 
     // vector of length cells with correspondent cluster ids
@@ -133,8 +276,8 @@ namespace HDG_WE
     std::vector<unsigned int> element_categories;
 
     // vectors of length cells with indicator for neighbors with smaller/bigger time step size
-    std::vector<bool> cell_have_faster_neighbor;
-    std::vector<bool> cell_have_slower_neighbor;
+    CellFlags cell_have_faster_neighbor;
+    CellFlags cell_have_slower_neighbor;
 
     // number of clusters
     unsigned int n_clusters;
@@ -150,12 +293,73 @@ namespace HDG_WE
     // improved gradient and divergence
     mutable LinearAlgebra::distributed::Vector<Number> improvedgraddiv;
 
-    // state vector
-    mutable LinearAlgebra::distributed::Vector<Number> state;
+    // face contributions of the current update, zero in between updates
+    mutable LinearAlgebra::distributed::Vector<Number> face_contributions;
+
+    // registers of the multirate Runge-Kutta scheme: the accumulated stage
+    // updates, the derivative of the current stage and the derivative at the
+    // start of the current step of each cluster
+    mutable LinearAlgebra::distributed::Vector<Number> stage_accumulator;
+    mutable LinearAlgebra::distributed::Vector<Number> stage_derivative;
+    mutable LinearAlgebra::distributed::Vector<Number> start_derivative;
 
   private:
-    // temporary state for reconstruction
-    mutable LinearAlgebra::distributed::Vector<Number> temporary_recon_state;
+    // cost of a cell of each cluster per global time step, either modeled
+    // from the number of updates or measured
+    mutable std::vector<double> cluster_cell_costs;
+    mutable bool costs_are_measured;
+
+    // measured time and number of updated cell batches per cluster as well as
+    // the time spent in perform_time_step since the last setup
+    mutable std::vector<double> cluster_update_time;
+    mutable std::vector<double> cluster_updated_batches;
+    mutable double step_time;
+
+    // locally owned cell batches of each cluster
+    std::vector<unsigned int> cluster_n_owned_cells;
+
+    // connection of cell_weight to the triangulation
+    boost::signals2::connection weight_connection;
+
+    double repartition_threshold;
+
+    // clusters of the non-artificial cells of the last categorization and the
+    // quantities its mapping from time step levels to clusters depends on.
+    // After mesh adaptation, only cells without a stored cluster and their
+    // neighbors are categorized again.
+    std::map<CellId,unsigned int> previous_cluster_ids;
+    Number previous_fastest_time_step;
+    unsigned int previous_n_levels;
+    unsigned int optimized_n_clusters;
+
+    // active cell indices of the non-artificial face neighbors of a cell
+    template <int dim> void collect_face_neighbors(const typename Triangulation<dim>::cell_iterator &cell,
+                                                   std::vector<unsigned int> &neighbors) const;
+
+    // find the number of clusters and the time step difference with the
+    // lowest predicted cost per simulated time for cells with the given time
+    // step levels (multiples of the smallest time step)
+    template <int dim> void optimize_cluster_configuration(const Triangulation<dim> &tria,
+                                                           const std::vector<unsigned int> &levels,
+                                                           const unsigned int n_levels,
+                                                           const unsigned int max_clusters,
+                                                           const unsigned int max_diff,
+                                                           unsigned int &best_n_clusters,
+                                                           unsigned int &best_diff) const;
+
+    // recompute cluster_cell_costs, from the measured timings of all ranks if
+    // available
+    void update_cluster_cell_costs() const;
+
+    // time step of a cluster in multiples of the fastest time step
+    unsigned int time_step_multiple(const unsigned int cluster) const
+    {
+      return nested_time_steps ? (1U<<cluster) : cluster_diff*cluster+1;
+    }
+
+    // cells temporarily advanced for the reconstruction and their old values
+    mutable std::vector<unsigned int> saved_cells;
+    mutable AlignedVector<VectorizedArray<Number> > saved_values;
 
     // vector of length clusters with correspondent time levels
     mutable std::vector<Number> cluster_timelevels;
@@ -182,10 +386,10 @@ namespace HDG_WE
     unsigned int n_cells;
 
     // vector with flags for cell evaluation
-    mutable std::vector<bool> evaluate_cell;
+    mutable CellFlags evaluate_cell;
 
     // vector with flags for cell evaluation
-    mutable std::vector<bool> update_cell;
+    mutable CellFlags update_cell;
 
     // vector with flags for face evaluation
     mutable std::vector<bool> evaluate_face;
@@ -205,25 +409,181 @@ namespace HDG_WE
     // use ader post
     bool use_ader_post;
 
+    // choose the cluster configuration from the cost model
+    bool optimize_clusters;
+
+    // relative costs of the cost model, see enable_cluster_optimization()
+    double relative_interface_cost;
+    double relative_reconstruction_cost;
+
+    // time steps of the clusters are powers of two of the fastest one
+    bool nested_time_steps;
+
     // masks for each face
     mutable std::vector<std::bitset<n_vect> > phi_to_dst;
     mutable std::vector<std::bitset<n_vect> > phi_neighbor_to_dst;
     mutable std::vector<std::bitset<n_vect> > phi_to_fluxmemory;
     mutable std::vector<std::bitset<n_vect> > phi_neighbor_to_fluxmemory;
 
-    // helper vectors to avoid the get_cell_iterator in update_elements
-    std::vector<std::vector<std::bitset<n_vect> > > cell_neighbor_has_children; // order is n,e,v
-    std::vector<std::vector<std::vector<int> > > cell_neighbor_index;           // order is n,v,e
-    std::vector<std::vector<std::vector<int> > > cell_neighbor_active_cell_index; // order is n,v,e
+    // macro cells sharing a face with a macro cell (in both directions), the
+    // neighbors of cell e are cell_neighbor_list[cell_neighbor_start[e]] to
+    // cell_neighbor_list[cell_neighbor_start[e+1]-1]
+    std::vector<unsigned int> cell_neighbor_start;
+    std::vector<unsigned int> cell_neighbor_list;
+
+    // macro cells and face batches touched by the cells of each cluster
+    std::vector<std::vector<unsigned int> > cluster_cells;
+    std::vector<std::vector<unsigned int> > cluster_faces;
+
+    // index ranges spanned by the locally owned cell batches and the face
+    // batches of each cluster
+    std::vector<std::pair<unsigned int,unsigned int> > cluster_cell_ranges;
+    std::vector<std::pair<unsigned int,unsigned int> > cluster_inner_face_ranges;
+    std::vector<std::pair<unsigned int,unsigned int> > cluster_boundary_face_ranges;
+
+    // cluster whose cells and faces are currently flagged
+    mutable unsigned int evaluated_cluster;
+
+    // locally owned cell batches of each cluster, and those among them with a
+    // neighbor in the faster or the slower cluster
+    std::vector<std::vector<unsigned int> > cluster_owned_cells;
+    std::vector<std::vector<unsigned int> > faster_interface_cells;
+    std::vector<std::vector<unsigned int> > slower_interface_cells;
+
+    // values and derivatives of the faster_interface_cells at the start of
+    // the current step of their cluster, from which the faster cluster
+    // extrapolates them
+    mutable std::vector<AlignedVector<VectorizedArray<Number> > > cluster_start_values;
+    mutable std::vector<AlignedVector<VectorizedArray<Number> > > cluster_start_derivatives;
+
+    // values of the slower_interface_cells after each step of their cluster
+    // within the current step of the slower cluster, from which the slower
+    // cluster interpolates them, and the time of the first entry
+    mutable std::vector<std::vector<AlignedVector<VectorizedArray<Number> > > > interface_history;
+    mutable std::vector<Number> interface_history_start;
+
+    // flags for neighbors of update cells which are no update cells themselves
+    mutable CellFlags is_neighbor_of_update_cell;
+
+    // flagged cells and faces, used to reset the flags without a full scan
+    mutable std::vector<unsigned int> update_cell_list;
+    mutable std::vector<unsigned int> evaluate_cell_list;
+    mutable std::vector<unsigned int> evaluate_face_list;
+
+    // cell batch and cluster of each lane of the face batches, stored face by
+    // face. Empty lanes point to the cell batch n_cells_with_ghosts, whose
+    // flags are never set, and to an invalid cluster.
+    std::vector<unsigned int> face_cells_interior;
+    std::vector<unsigned int> face_cells_exterior;
+    std::vector<unsigned int> face_clusters_interior;
+    std::vector<unsigned int> face_clusters_exterior;
+
+    // flags of the cells on one side of a face batch, one bit per lane
+    std::bitset<n_vect> face_flags(const CellFlags                 &flags,
+                                   const std::vector<unsigned int> &face_cells,
+                                   const unsigned int               face) const
+    {
+      unsigned long bits = 0;
+      for (unsigned int v=0; v<n_vect; ++v)
+        bits |= static_cast<unsigned long>(flags[face_cells[face*n_vect+v]]) << v;
+      return std::bitset<n_vect>(bits);
+    }
+
+    // lanes of one side of a face batch with a cell of the given cluster
+    std::bitset<n_vect> face_cluster_flags(const std::vector<unsigned int> &face_clusters,
+                                           const unsigned int               face,
+                                           const unsigned int               cluster) const
+    {
+      unsigned long bits = 0;
+      for (unsigned int v=0; v<n_vect; ++v)
+        bits |= static_cast<unsigned long>(face_clusters[face*n_vect+v]==cluster) << v;
+      return std::bitset<n_vect>(bits);
+    }
 
-    std::vector<std::vector<unsigned int> > mf_faceinfo_cellsminus;
-    std::vector<std::vector<unsigned int> > mf_faceinfo_cellsplus;
+    // compact flux memory index of each cell batch
+    std::vector<unsigned int> flux_memory_index;
+    unsigned int n_flux_memory_batches;
+
+    // flux memory exchange: per neighboring rank, the compact index and lane
+    // of the ghost cells sent to it and of the owned cells received from it,
+    // in matching order
+    std::vector<std::pair<unsigned int,std::vector<std::pair<unsigned int,unsigned int> > > > flux_memory_send_cells;
+    std::vector<std::pair<unsigned int,std::vector<std::pair<unsigned int,unsigned int> > > > flux_memory_recv_cells;
+
+    // number the interface cell batches and set up the exchange of their
+    // ghosts with the owners
+    template <typename Operator> void setup_flux_memory(const Operator &op);
+
+    // ghost exchange per cluster: for each neighboring rank, the local vector
+    // indices of the owned dofs it holds as ghosts and of the ghost dofs owned
+    // by it, per cluster in matching order on both sides
+    std::vector<unsigned int> ghost_exchange_ranks;
+    std::vector<std::vector<std::vector<unsigned int> > > ghost_send_dofs;
+    std::vector<std::vector<std::vector<unsigned int> > > ghost_recv_dofs;
+
+    // clusters whose ghost cells take part in the next exchange
+    mutable unsigned int ghost_clusters_begin, ghost_clusters_end;
+
+    template <typename Operator> void setup_ghost_exchange(const Operator &op);
+
+    // restrict the ghost exchange to the clusters first to last
+    void set_ghost_clusters(const unsigned int first,
+                            const unsigned int last) const
+    {
+      ghost_clusters_begin = first;
+      ghost_clusters_end = last+1;
+    }
 
     template <typename Operator> void update_elements(const Operator &op,
-                                                      LinearAlgebra::distributed::Vector<Number>        &dst,
                                                       LinearAlgebra::distributed::Vector<Number>        &local_state,
                                                       const unsigned int actual_cluster,
                                                       const bool write_to_fluxmemory = true) const;
+
+    template <typename Operator> void setup_interface_faces(const Operator &op,
+                                                            const unsigned int actual_cluster,
+                                                            const bool write_to_fluxmemory) const;
+
+    // advance a cluster by one of its steps, after subcycling the faster
+    // clusters over the same interval
+    template <typename Operator> void advance_cluster(const Operator &op,
+                                                      const unsigned int cluster,
+                                                      const std::vector<double> &stage_factors,
+                                                      const std::vector<double> &weights,
+                                                      const std::vector<double> &stage_times,
+                                                      LinearAlgebra::distributed::Vector<Number> &state) const;
+
+    // derivative of the cells of a cluster at the given time, with the
+    // interface cells of the neighboring clusters brought to that time
+    template <typename Operator> void evaluate_cluster_derivative(const Operator &op,
+                                                                  const unsigned int cluster,
+                                                                  const Number time,
+                                                                  LinearAlgebra::distributed::Vector<Number> &state,
+                                                                  LinearAlgebra::distributed::Vector<Number> &derivative) const;
+
+    // flag the given cells of a cluster for evaluation together with the
+    // faces of the cluster next to them, masked to write only to these cells
+    template <typename Operator> void select_evaluate_cells(const Operator &op,
+                                                            const unsigned int cluster,
+                                                            const std::vector<unsigned int> &cells) const;
+
+    // select the cells of cluster at the interface and their neighbors in cluster as update cells
+    void select_interface_cells(const unsigned int cluster,
+                                const CellFlags &at_interface) const;
+
+    // save the state of the locally owned update cells before a reconstruction update
+    template <typename Operator> void save_update_cells(const Operator &op,
+                                                        const LinearAlgebra::distributed::Vector<Number> &state) const;
+
+    void mark_cell(CellFlags &flags,
+                   std::vector<unsigned int> &list,
+                   const unsigned int cell) const;
+
+    void clear_cells(CellFlags &flags,
+                     std::vector<unsigned int> &list) const;
+
+    void mark_face(const unsigned int face) const;
+
+    void clear_faces() const;
   };
 
 }
@@ -18,6 +18,9 @@
 
 #include "cluster_manager.h"
 
+#include <numeric>
+#include <set>
+
 namespace HDG_WE
 {
 
@@ -79,35 +82,115 @@ namespace HDG_WE
     n_clusters++; // number of clusters is one more than highest cluster id
     n_clusters = Utilities::MPI::max(n_clusters,MPI_COMM_WORLD);
 
+    // after mesh adaptation with the same time step levels, the cells that
+    // were neither refined nor coarsened keep their clusters. Only the new
+    // cells and their neighbors, which may have lost a faster or slower
+    // neighbor, are categorized again.
+    const bool incremental = Utilities::MPI::min(int(!previous_cluster_ids.empty()
+                                                     && previous_fastest_time_step == minimaltimestep
+                                                     && previous_n_levels == n_clusters),
+                                                 MPI_COMM_WORLD);
+    previous_fastest_time_step = minimaltimestep;
+    previous_n_levels = n_clusters;
+    std::vector<bool> recompute_cell(tria.n_active_cells(),!incremental);
+    std::vector<unsigned int> neighbors;
+    if (incremental)
+      for (cell = tria.begin_active(); cell!=endc; ++cell)
+        if (!cell->is_artificial() && previous_cluster_ids.find(cell->id()) == previous_cluster_ids.end())
+          {
+            recompute_cell[cell->active_cell_index()] = true;
+            collect_face_neighbors<dim>(cell,neighbors);
+            for (unsigned int i=0; i<neighbors.size(); ++i)
+              recompute_cell[neighbors[i]] = true;
+          }
+
     // here, we already have to find a valid clustering, not later!
-    cluster_diff = 1;
+    if (!incremental)
+      cluster_diff = 1;
     if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0)
       std::cout<<"ncluster vorher "<<n_clusters<<std::endl;
-    if (n_clusters>max_clusters)
+    if (nested_time_steps)
+      {
+        // cluster c advances with 2^c times the smallest time step, which
+        // must not exceed the time step level of its cells
+        for (unsigned int ac=0; ac<tria.n_active_cells(); ++ac)
+          if (recompute_cell[ac])
+            {
+              unsigned int c = 0;
+              while (c+1<max_clusters && (2U<<c)<=temporary_cluster_ids[ac]+1)
+                ++c;
+              temporary_cluster_ids[ac] = c;
+            }
+      }
+    else if (optimize_clusters)
+      {
+        if (!incremental)
+          {
+            optimized_n_clusters = n_clusters;
+            optimize_cluster_configuration(tria,temporary_cluster_ids,n_clusters,max_clusters,max_diff,optimized_n_clusters,cluster_diff);
+          }
+        for (unsigned int ac=0; ac<tria.n_active_cells(); ++ac)
+          if (recompute_cell[ac])
+            temporary_cluster_ids[ac] = std::min(temporary_cluster_ids[ac]/cluster_diff,optimized_n_clusters-1);
+      }
+    else if (n_clusters>max_clusters)
       {
-        cluster_diff = n_clusters/max_clusters+1;
-        cluster_diff = std::min(cluster_diff,max_diff);
+        if (!incremental)
+          {
+            cluster_diff = n_clusters/max_clusters+1;
+            cluster_diff = std::min(cluster_diff,max_diff);
+          }
         for (unsigned int ac=0; ac<tria.n_active_cells(); ++ac)
-          temporary_cluster_ids[ac] = temporary_cluster_ids[ac]/cluster_diff;
+          if (recompute_cell[ac])
+            temporary_cluster_ids[ac] = temporary_cluster_ids[ac]/cluster_diff;
       }
+    if (incremental)
+      for (cell = tria.begin_active(); cell!=endc; ++cell)
+        if (!cell->is_artificial() && !recompute_cell[cell->active_cell_index()])
+          temporary_cluster_ids[cell->active_cell_index()] = previous_cluster_ids[cell->id()];
     if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0)
       std::cout<<"actual cluster diff "<<cluster_diff<<std::endl;
 
-    cell_have_faster_neighbor.resize(tria.n_active_cells());
-    cell_have_slower_neighbor.resize(tria.n_active_cells());
+    cell_have_faster_neighbor.reinit(tria.n_active_cells());
+    cell_have_slower_neighbor.reinit(tria.n_active_cells());
+
+    // cells whose neighbors are adjusted in the current and the next sweep,
+    // in the incremental case only the cells around changed clusters
+    std::vector<bool> sweep_cell(tria.n_active_cells(),!incremental);
+    std::vector<bool> next_sweep_cell(tria.n_active_cells(),false);
+    auto mark_for_sweep = [&](const typename Triangulation<dim>::cell_iterator &marked_cell)
+    {
+      if (!incremental)
+        return;
+      sweep_cell[marked_cell->active_cell_index()] = true;
+      next_sweep_cell[marked_cell->active_cell_index()] = true;
+      collect_face_neighbors<dim>(marked_cell,neighbors);
+      for (unsigned int i=0; i<neighbors.size(); ++i)
+        {
+          sweep_cell[neighbors[i]] = true;
+          next_sweep_cell[neighbors[i]] = true;
+        }
+    };
+    if (incremental)
+      for (cell = tria.begin_active(); cell!=endc; ++cell)
+        if (!cell->is_artificial() && recompute_cell[cell->active_cell_index()])
+          mark_for_sweep(cell);
 
     bool faster_and_slower_neighbor = true;
     unsigned int count = 0;
     while (faster_and_slower_neighbor && count<100)
       {
         count++;
-        cell_have_faster_neighbor.clear();
-        cell_have_slower_neighbor.clear();
+        if (incremental && count>1)
+          {
+            sweep_cell.swap(next_sweep_cell);
+            std::fill(next_sweep_cell.begin(),next_sweep_cell.end(),false);
+          }
         for (unsigned int c=0; c<n_clusters; ++c)
           {
             typename Triangulation<dim>::active_cell_iterator cell = tria.begin_active(),endc = tria.end();
             for (; cell!=endc; ++cell)
-              if (!cell->is_artificial() && !cell->is_ghost())
+              if (!cell->is_artificial() && !cell->is_ghost() && sweep_cell[cell->active_cell_index()])
                 {
                   if (temporary_cluster_ids[cell->active_cell_index()] == c)
                     {
@@ -134,23 +217,21 @@ namespace HDG_WE
                                 {
                                   for (unsigned int subfaces = 0; subfaces < GeometryInfo<dim>::max_children_per_face; ++subfaces)
                                     {
-                                      if (temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()]>c)
+                                      const unsigned int new_id = is_anyone_faster ? c : c+1;
+                                      if (temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()]>new_id)
                                         {
-                                          if (is_anyone_faster)
-                                            temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()] = c;
-                                          else
-                                            temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()] = c+1;
+                                          temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()] = new_id;
+                                          mark_for_sweep(cell->neighbor_child_on_subface(n,subfaces));
                                         }
                                     }
                                 }
                               else if (!cell->neighbor(n)->is_artificial())
                                 {
-                                  if (temporary_cluster_ids[cell->neighbor(n)->active_cell_index()]>c)
+                                  const unsigned int new_id = is_anyone_faster ? c : c+1;
+                                  if (temporary_cluster_ids[cell->neighbor(n)->active_cell_index()]>new_id)
                                     {
-                                      if (is_anyone_faster)
-                                        temporary_cluster_ids[cell->neighbor(n)->active_cell_index()] = c;
-                                      else
-                                        temporary_cluster_ids[cell->neighbor(n)->active_cell_index()] = c+1;
+                                      temporary_cluster_ids[cell->neighbor(n)->active_cell_index()] = new_id;
+                                      mark_for_sweep(cell->neighbor(n));
                                     }
                                 }
                             }
@@ -177,12 +258,15 @@ namespace HDG_WE
           for (; cell!=endc; ++cell)
             if (!cell->is_artificial())
               {
-                temporary_cluster_ids[cell->active_cell_index()] = distributed_cell_categories[contiguous_dof_index_for_cell[cell->active_cell_index()]];
+                const unsigned int new_id = distributed_cell_categories[contiguous_dof_index_for_cell[cell->active_cell_index()]];
+                if (new_id != temporary_cluster_ids[cell->active_cell_index()])
+                  mark_for_sweep(cell);
+                temporary_cluster_ids[cell->active_cell_index()] = new_id;
               }
         }
         // determine if a cell has a faster neighbor
-        cell_have_faster_neighbor.resize(tria.n_active_cells(),false);
-        cell_have_slower_neighbor.resize(tria.n_active_cells(),false);
+        cell_have_faster_neighbor.reinit(tria.n_active_cells());
+        cell_have_slower_neighbor.reinit(tria.n_active_cells());
 
         faster_and_slower_neighbor = false;
         typename Triangulation<dim>::active_cell_iterator cell = tria.begin_active(),endc = tria.end();
@@ -192,6 +276,7 @@ namespace HDG_WE
               unsigned int current_c = temporary_cluster_ids[cell->active_cell_index()];
               bool is_anyone_faster = false;
               bool is_anyone_slower = false;
+              bool is_invalid = false;
               for (unsigned int n=0; n<GeometryInfo<dim>::faces_per_cell; ++n)
                 {
                   if (cell->neighbor_index(n)>=0)
@@ -203,17 +288,17 @@ namespace HDG_WE
                               if (temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()]<current_c)
                                 {
                                   is_anyone_faster = true;
-                                  cell_have_faster_neighbor[cell->active_cell_index()] = true;
+                                  cell_have_faster_neighbor.set(cell->active_cell_index());
                                 }
                               else if (temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()]>current_c)
                                 {
                                   is_anyone_slower = true;
-                                  cell_have_slower_neighbor[cell->active_cell_index()] = true;
+                                  cell_have_slower_neighbor.set(cell->active_cell_index());
                                 }
                               if (int(temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()])<int(current_c-1)
                                   ||  temporary_cluster_ids[cell->neighbor_child_on_subface(n,subfaces)->active_cell_index()]>current_c+1)
                                 {
-                                  faster_and_slower_neighbor = true;
+                                  is_invalid = true;
                                 }
                             }
                         }
@@ -222,24 +307,29 @@ namespace HDG_WE
                           if (temporary_cluster_ids[cell->neighbor(n)->active_cell_index()]<current_c)
                             {
                               is_anyone_faster = true;
-                              cell_have_faster_neighbor[cell->active_cell_index()] = true;
+                              cell_have_faster_neighbor.set(cell->active_cell_index());
                             }
                           else if (temporary_cluster_ids[cell->neighbor(n)->active_cell_index()]>current_c)
                             {
                               is_anyone_slower = true;
-                              cell_have_slower_neighbor[cell->active_cell_index()] = true;
+                              cell_have_slower_neighbor.set(cell->active_cell_index());
                             }
                           if (int(temporary_cluster_ids[cell->neighbor(n)->active_cell_index()])<int(current_c-1)
                               ||  temporary_cluster_ids[cell->neighbor(n)->active_cell_index()]>current_c+1)
                             {
-                              faster_and_slower_neighbor = true;
+                              is_invalid = true;
                             }
                         }
                     }
                 }
               if (is_anyone_faster&&is_anyone_slower)
+                {
+                  is_invalid = true;
+                }
+              if (is_invalid)
                 {
                   faster_and_slower_neighbor = true;
+                  mark_for_sweep(cell);
                 }
             } // for (; cell!=endc; ++cell)
         faster_and_slower_neighbor = Utilities::MPI::max(double(faster_and_slower_neighbor),MPI_COMM_WORLD);
@@ -261,9 +351,114 @@ namespace HDG_WE
     n_clusters = Utilities::MPI::max(n_clusters,MPI_COMM_WORLD);
     if (!Utilities::MPI::this_mpi_process(MPI_COMM_WORLD))
       std::cout<<"final number of clusters "<<n_clusters<<std::endl;
+
+    previous_cluster_ids.clear();
+    for (cell = tria.begin_active(); cell!=endc; ++cell)
+      if (!cell->is_artificial())
+        previous_cluster_ids[cell->id()] = temporary_cluster_ids[cell->active_cell_index()];
   }
 
 
+
+  template <typename Number>
+  template <int dim>
+  void ClusterManager<Number>::collect_face_neighbors(const typename Triangulation<dim>::cell_iterator &cell,
+                                                      std::vector<unsigned int> &neighbors) const
+  {
+    neighbors.clear();
+    for (unsigned int n=0; n<GeometryInfo<dim>::faces_per_cell; ++n)
+      if (cell->neighbor_index(n)>=0 && !cell->neighbor(n)->is_artificial())
+        {
+          if (cell->neighbor(n)->has_children())
+            for (unsigned int subface=0; subface<GeometryInfo<dim>::max_children_per_face; ++subface)
+              neighbors.push_back(cell->neighbor_child_on_subface(n,subface)->active_cell_index());
+          else
+            neighbors.push_back(cell->neighbor(n)->active_cell_index());
+        }
+  }
+
+
+  template <typename Number>
+  template <int dim>
+  void ClusterManager<Number>::optimize_cluster_configuration(const Triangulation<dim> &tria,
+                                                              const std::vector<unsigned int> &levels,
+                                                              const unsigned int n_levels,
+                                                              const unsigned int max_clusters,
+                                                              const unsigned int max_diff,
+                                                              unsigned int &best_n_clusters,
+                                                              unsigned int &best_diff) const
+  {
+    // relative costs of the extra first ader step of interface cells and of
+    // the reconstruction (which updates the interface cells of the neighbors
+    // once more), in units of a cell update
+    const double interface_overhead = relative_interface_cost;
+    const double reconstruction_cost = use_ader_post ? relative_reconstruction_cost : 0.;
+
+    // candidates are all pairs of time step difference and number of clusters,
+    // the slowest cluster collects all cells with larger time steps
+    std::vector<std::pair<unsigned int,unsigned int> > candidates;
+    for (unsigned int diff=1; diff<=std::max(max_diff,1U); ++diff)
+      for (unsigned int n=1; n<=std::min(std::max(max_clusters,1U),(n_levels-1)/diff+1); ++n)
+        candidates.push_back(std::make_pair(diff,n));
+
+    // cost of all candidates per smallest time step, summed over the cells
+    std::vector<double> costs(candidates.size()+1,0.);
+    typename Triangulation<dim>::active_cell_iterator cell = tria.begin_active(), endc = tria.end();
+    for (; cell!=endc; ++cell)
+      if (cell->is_locally_owned())
+        {
+          const unsigned int level = levels[cell->active_cell_index()];
+          unsigned int min_neighbor_level = level, max_neighbor_level = level;
+          for (unsigned int n=0; n<GeometryInfo<dim>::faces_per_cell; ++n)
+            if (cell->neighbor_index(n)>=0 && !cell->neighbor(n)->is_artificial())
+              {
+                if (cell->neighbor(n)->has_children())
+                  for (unsigned int subface=0; subface<GeometryInfo<dim>::max_children_per_face; ++subface)
+                    {
+                      const unsigned int neighbor_level = levels[cell->neighbor_child_on_subface(n,subface)->active_cell_index()];
+                      min_neighbor_level = std::min(min_neighbor_level,neighbor_level);
+                      max_neighbor_level = std::max(max_neighbor_level,neighbor_level);
+                    }
+                else
+                  {
+                    const unsigned int neighbor_level = levels[cell->neighbor(n)->active_cell_index()];
+                    min_neighbor_level = std::min(min_neighbor_level,neighbor_level);
+                    max_neighbor_level = std::max(max_neighbor_level,neighbor_level);
+                  }
+              }
+
+          for (unsigned int i=0; i<candidates.size(); ++i)
+            {
+              const unsigned int diff = candidates[i].first;
+              const unsigned int n = candidates[i].second;
+              const unsigned int global_multiple = diff*(n-1)+1;
+              const unsigned int c = std::min(level/diff,n-1);
+              const bool at_interface = std::min(min_neighbor_level/diff,n-1) < c
+                                        || std::min(max_neighbor_level/diff,n-1) > c;
+              const double updates_per_step = std::ceil(double(global_multiple)/(diff*c+1));
+              costs[i] += updates_per_step/global_multiple
+                          * (1. + reconstruction_cost + (at_interface ? interface_overhead + reconstruction_cost : 0.));
+            }
+
+          // global time stepping updates every cell with the smallest time step
+          costs[candidates.size()] += 1. + reconstruction_cost;
+        }
+    Utilities::MPI::sum(costs,MPI_COMM_WORLD,costs);
+
+    unsigned int best = 0;
+    for (unsigned int i=1; i<candidates.size(); ++i)
+      if (costs[i] < costs[best])
+        best = i;
+    best_diff = candidates[best].first;
+    best_n_clusters = candidates[best].second;
+
+    if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0)
+      std::cout<<"optimized clusters: "<<best_n_clusters<<" clusters with time step difference "<<best_diff
+               <<", predicted speedup over global time stepping "<<costs[candidates.size()]/costs[best]<<std::endl;
+  }
+
+
+
   template <typename Number>
   template <int dim>
   void ClusterManager<Number>::propose_cluster_categorization(std::vector<unsigned int> &categories,
@@ -275,25 +470,48 @@ namespace HDG_WE
   {
     this->iterate_cluster_categorization(tria,dof_handlers,max_clusters,max_diff,cfl_number);
 
-    // cast triangulation
-    parallel::distributed::Triangulation<dim> *triapll = (dynamic_cast<parallel::distributed::Triangulation<dim>*>
-                                                          (const_cast<dealii::Triangulation<dim>*>
-                                                           (&tria)));
+    // keep measured costs as long as the clusters are the same
+    if (cluster_cell_costs.size() != n_clusters)
+      update_cluster_cell_costs();
 
-    // setup weights of cells for processors according to clusters
-    triapll->signals.cell_weight.connect([&] (const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
-                                              const typename parallel::distributed::Triangulation<dim>::CellStatus ) -> unsigned int
-    { return (n_clusters-int(element_categories[cell->active_cell_index()]/3)-1)*cluster_diff*1000; });
+    // the weights only need to be connected once, afterwards the refinement
+    // and repartition() of the triangulation apply them by themselves
+    if (!weight_connection.connected())
+      {
+        // cast triangulation
+        parallel::distributed::Triangulation<dim> *triapll = (dynamic_cast<parallel::distributed::Triangulation<dim>*>
+                                                              (const_cast<dealii::Triangulation<dim>*>
+                                                               (&tria)));
+
+        // setup weights of cells for processors according to clusters
+        weight_connection = triapll->signals.cell_weight.connect([this] (const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+                                                                         const typename parallel::distributed::Triangulation<dim>::CellStatus status) -> unsigned int
+        { return this->template cell_weight<dim>(cell,status); });
+
+        // the repartitioning and the second categorization only pay off if
+        // the weights are unevenly distributed
+        double local_weight = 0.;
+        typename Triangulation<dim>::active_cell_iterator cell = tria.begin_active(), endc = tria.end();
+        for (; cell!=endc; ++cell)
+          if (cell->is_locally_owned())
+            local_weight += 1000 + cell_weight<dim>(cell,parallel::distributed::Triangulation<dim>::CELL_PERSIST);
+        const Utilities::MPI::MinMaxAvg weight = Utilities::MPI::min_max_avg(local_weight,MPI_COMM_WORLD);
 
-    // repartition triangulation
-    triapll->repartition();
+        if (weight.max > (1.+repartition_threshold)*weight.avg)
+          {
+            // repartition triangulation
+            triapll->repartition();
 
-    // tell all the dof handlers what happened
-    for (unsigned int i=0; i<dof_handlers.size(); ++i)
-      (const_cast<dealii::DoFHandler<dim> *>(dof_handlers[i]))->distribute_dofs(dof_handlers[i]->get_fe());
+            // tell all the dof handlers what happened
+            for (unsigned int i=0; i<dof_handlers.size(); ++i)
+              (const_cast<dealii::DoFHandler<dim> *>(dof_handlers[i]))->distribute_dofs(dof_handlers[i]->get_fe());
 
-    // setup the cluster proposition according to the new cell distribution - don't try anything too smart, just do it again
-    this->iterate_cluster_categorization(tria,dof_handlers,max_clusters,max_diff,cfl_number);
+            // setup the cluster proposition according to the new cell distribution - don't try anything too smart, just do it again
+            this->iterate_cluster_categorization(tria,dof_handlers,max_clusters,max_diff,cfl_number);
+            if (cluster_cell_costs.size() != n_clusters)
+              update_cluster_cell_costs();
+          }
+      }
 
     // bring in shape and fill
     categories.resize(tria.n_active_cells());
@@ -304,11 +522,87 @@ namespace HDG_WE
   }
 
 
+  template <typename Number>
+  template <int dim>
+  unsigned int ClusterManager<Number>::cell_weight(const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+                                                   const typename parallel::distributed::Triangulation<dim>::CellStatus ) const
+  {
+    // the categories refer to the active cells of the last categorization,
+    // cells refined in the meantime take the category of their first child
+    typename parallel::distributed::Triangulation<dim>::cell_iterator active_cell = cell;
+    while (active_cell->has_children())
+      active_cell = active_cell->child(0);
+    if (active_cell->active_cell_index() >= element_categories.size() || cluster_cell_costs.empty())
+      return 0;
+
+    const unsigned int category = element_categories[active_cell->active_cell_index()];
+    double cost = cluster_cell_costs[std::min(category/3,n_clusters-1)];
+
+    // without measurements, account for the additional first ader step at
+    // the interface to other clusters
+    if (!costs_are_measured && category%3 != 0)
+      cost *= 1.5;
+
+    const double min_cost = *std::min_element(cluster_cell_costs.begin(),cluster_cell_costs.end());
+    return static_cast<unsigned int>(1000.*(cost/min_cost-1.)+0.5);
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::update_cluster_cell_costs() const
+  {
+    std::vector<double> times(n_clusters,0.), batches(n_clusters,0.);
+    if (cluster_update_time.size() == n_clusters)
+      {
+        Utilities::MPI::sum(cluster_update_time,MPI_COMM_WORLD,times);
+        Utilities::MPI::sum(cluster_updated_batches,MPI_COMM_WORLD,batches);
+      }
+
+    costs_are_measured = true;
+    for (unsigned int c=0; c<n_clusters; ++c)
+      if (batches[c] == 0. || times[c] == 0.)
+        costs_are_measured = false;
+
+    // number of updates of each cluster per global time step times the
+    // cost of one update, which the measurement gives including the
+    // polynomial degree, the interface faces and the post processing
+    const unsigned int max_level = time_step_multiple(n_clusters-1);
+    cluster_cell_costs.resize(n_clusters);
+    for (unsigned int c=0; c<n_clusters; ++c)
+      {
+        const double n_updates_per_step = std::ceil(double(max_level)/time_step_multiple(c));
+        cluster_cell_costs[c] = n_updates_per_step * (costs_are_measured ? times[c]/batches[c] : 1.);
+      }
+  }
+
+
+
+  template <typename Number>
+  double ClusterManager<Number>::load_imbalance() const
+  {
+    const Utilities::MPI::MinMaxAvg time = Utilities::MPI::min_max_avg(step_time,MPI_COMM_WORLD);
+    update_cluster_cell_costs();
+
+    if (!Utilities::MPI::this_mpi_process(MPI_COMM_WORLD))
+      {
+        std::cout<<"LTS time per rank min/avg/max "<<time.min<<" "<<time.avg<<" "<<time.max<<" s, cell costs per cluster";
+        for (unsigned int c=0; c<n_clusters; ++c)
+          std::cout<<" "<<cluster_cell_costs[c]/cluster_cell_costs[0];
+        std::cout<<(costs_are_measured ? " (measured)" : " (modeled)")<<std::endl;
+      }
+
+    return time.avg > 0. ? time.max/time.avg-1. : 0.;
+  }
+
+
+
   template <typename Number>
   template <typename Operator>
   void ClusterManager<Number>::setup_mf_index_to_cell_index(const Operator &op)
   {
-    mf_index.resize(op.get_matrix_free().get_dof_handler(0).get_triangulation().n_active_cells());
+    mf_index.clear();
+    mf_index.resize(op.get_matrix_free().get_dof_handler(0).get_triangulation().n_active_cells(),-1);
 
     for (unsigned int i=0; i<n_cells_with_ghosts; ++i)
       for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(i); ++v)
@@ -332,10 +626,8 @@ namespace HDG_WE
     setup_mf_index_to_cell_index(op);
 
     // setup everything in matrixfree layout
-    cell_have_slower_neighbor.clear();
-    cell_have_faster_neighbor.clear();
-    cell_have_slower_neighbor.resize(n_cells_with_ghosts);
-    cell_have_faster_neighbor.resize(n_cells_with_ghosts);
+    cell_have_slower_neighbor.reinit(n_cells_with_ghosts);
+    cell_have_faster_neighbor.reinit(n_cells_with_ghosts);
     cell_cluster_ids.resize(n_cells_with_ghosts);
 
     // read the cluster categorization
@@ -345,17 +637,15 @@ namespace HDG_WE
           unsigned int index = op.get_matrix_free().get_cell_iterator(cell,v)->active_cell_index();
           cell_cluster_ids[cell] = int(element_categories[index]/3); // use the categories to determine cluster and faster and slower
           if (element_categories[index]%3==2)
-            cell_have_faster_neighbor[cell] = true;
+            cell_have_faster_neighbor.set(cell);
           if (element_categories[index]%3==1)
-            cell_have_slower_neighbor[cell] = true;
+            cell_have_slower_neighbor.set(cell);
 
         }
 
     // next stuff to init
     cluster_timelevels.clear();
     cell_timelevels.clear();
-    evaluate_cell.clear();
-    update_cell.clear();
     evaluate_face.clear();
     phi_to_dst.clear();
     phi_neighbor_to_dst.clear();
@@ -363,8 +653,9 @@ namespace HDG_WE
     phi_neighbor_to_fluxmemory.clear();
     cluster_timelevels.resize(n_clusters,op.get_time_control().get_time());
     cell_timelevels.resize(n_cells_with_ghosts,op.get_time_control().get_time());
-    evaluate_cell.resize(n_cells_with_ghosts,false);
-    update_cell.resize(n_cells_with_ghosts,false);
+    // one more flag for the empty lanes of the face batches
+    evaluate_cell.reinit(n_cells_with_ghosts+1);
+    update_cell.reinit(n_cells_with_ghosts+1);
     evaluate_face.resize(op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(),false);
     phi_to_dst.resize(op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches());
     phi_neighbor_to_dst.resize(op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches());
@@ -374,7 +665,8 @@ namespace HDG_WE
     // set the cluster time steps
     cluster_timestepmultiples.resize(n_clusters);
     for (unsigned c=0; c<n_clusters; ++c)
-      cluster_timestepmultiples[c] = cluster_diff*int(c)+1;
+      cluster_timestepmultiples[c] = time_step_multiple(c);
+    const unsigned int max_level = cluster_timestepmultiples[n_clusters-1];
 
     // some statistics
     std::vector<unsigned int> num_cell_cluster(n_clusters,0);
@@ -391,7 +683,7 @@ namespace HDG_WE
         std::cout<<"cluster_timestepmultiples"<<std::endl;
         for (unsigned c=0; c<n_clusters; ++c)
           std::cout<<cluster_timestepmultiples[c]<<std::endl;
-        std::cout<<"n_clusters "<<n_clusters<<" clusterdiff "<<cluster_diff<<" levelmax "<<cluster_diff*(n_clusters-1)+1<<std::endl;
+        std::cout<<"n_clusters "<<n_clusters<<" clusterdiff "<<cluster_diff<<" levelmax "<<max_level<<std::endl;
       }
 
     // determine how one updates from one global time step to the next
@@ -403,12 +695,11 @@ namespace HDG_WE
     // need this clear for adaptivity
     cluster_update_times.clear();
     cluster_update_order.clear();
-    unsigned int max_level = cluster_diff*(n_clusters-1)+1;
     while (*std::min_element(templevels.begin(),templevels.end())<max_level)
       {
         for (unsigned c=0; c<n_clusters; ++c)
           {
-            if (templevels[c]<cluster_diff*(n_clusters-1)+1)
+            if (templevels[c]<max_level)
               {
                 if (c==0)
                   {
@@ -452,19 +743,19 @@ namespace HDG_WE
 
     // correct for too long updates
     for (unsigned c=0; c<n_clusters; ++c)
-      if (templevels[c]>cluster_diff*(n_clusters-1)+1)
+      if (templevels[c]>max_level)
         {
-          templevels[c] = cluster_diff*(n_clusters-1)+1;
+          templevels[c] = max_level;
         }
 
     // tell the wave equation problem with which maximum time step we update
-    op.get_time_control().set_time_step(fastest_time_step*(cluster_diff*(n_clusters-1)+1));
+    op.get_time_control().set_time_step(fastest_time_step*max_level);
 
     n_updates = cluster_update_order.size();
 
     for (unsigned c=0; c<cluster_update_times.size(); ++c)
-      if (cluster_update_times[c][1]>(cluster_diff*(n_clusters-1)+1)*fastest_time_step)
-        cluster_update_times[c][1] = (cluster_diff*(n_clusters-1)+1)*fastest_time_step;
+      if (cluster_update_times[c][1]>max_level*fastest_time_step)
+        cluster_update_times[c][1] = max_level*fastest_time_step;
 
     for (unsigned c=0; c<cluster_update_times.size(); ++c)
       {
@@ -476,58 +767,505 @@ namespace HDG_WE
     //for(unsigned c=0; c<cluster_update_order.size(); ++c)
     //  std::cout<<"c "<<c<<" updatecluster "<<cluster_update_order[c]<<std::endl;
 
-    // minimizing the calls to get_cell_iterator in update_cells by storing respective indices beforehand
-    cell_neighbor_has_children.clear();
-    cell_neighbor_index.clear();
-    cell_neighbor_active_cell_index.clear();
+    // neighbor cell batches of each cell batch, including the children behind
+    // refined faces, such that the update routines never need to call
+    // get_cell_iterator. The relation is stored symmetrically, in compressed
+    // row storage.
+    std::vector<std::vector<unsigned int> > cell_neighbor_batches(n_cells_with_ghosts);
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+      for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
+        {
+          const typename DoFHandler<Operator::dimension>::cell_iterator cell = op.get_matrix_free().get_cell_iterator(e,v);
+          for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
+            if (cell->neighbor_index(n) >= 0)
+              {
+                std::vector<unsigned int> neighbor_active_indices;
+                if (cell->neighbor(n)->has_children())
+                  for (unsigned int subface=0; subface<GeometryInfo<Operator::dimension>::max_children_per_face; ++subface)
+                    neighbor_active_indices.push_back(cell->neighbor_child_on_subface(n,subface)->active_cell_index());
+                else
+                  neighbor_active_indices.push_back(cell->neighbor(n)->active_cell_index());
 
-    cell_neighbor_has_children.resize(GeometryInfo<Operator::dimension>::faces_per_cell);
-    cell_neighbor_index.resize(GeometryInfo<Operator::dimension>::faces_per_cell);
-    cell_neighbor_active_cell_index.resize(GeometryInfo<Operator::dimension>::faces_per_cell);
-    for (unsigned n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
+                for (unsigned int i=0; i<neighbor_active_indices.size(); ++i)
+                  if (mf_index[neighbor_active_indices[i]] >= 0 && static_cast<unsigned int>(mf_index[neighbor_active_indices[i]]) != e)
+                    {
+                      const unsigned int neighbor = mf_index[neighbor_active_indices[i]];
+                      cell_neighbor_batches[e].push_back(neighbor);
+                      cell_neighbor_batches[neighbor].push_back(e);
+                    }
+              }
+        }
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
       {
-        cell_neighbor_has_children[n].resize(n_cells_with_ghosts);
-        cell_neighbor_index[n].resize(n_vect);
-        cell_neighbor_active_cell_index[n].resize(n_vect);
-        for (unsigned v=0; v<n_vect; ++v)
+        std::sort(cell_neighbor_batches[e].begin(), cell_neighbor_batches[e].end());
+        cell_neighbor_batches[e].erase(std::unique(cell_neighbor_batches[e].begin(), cell_neighbor_batches[e].end()),
+                                       cell_neighbor_batches[e].end());
+      }
+    cell_neighbor_start.resize(n_cells_with_ghosts+1);
+    cell_neighbor_start[0] = 0;
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+      cell_neighbor_start[e+1] = cell_neighbor_start[e]+cell_neighbor_batches[e].size();
+    cell_neighbor_list.resize(cell_neighbor_start[n_cells_with_ghosts]);
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+      std::copy(cell_neighbor_batches[e].begin(),cell_neighbor_batches[e].end(),
+                cell_neighbor_list.begin()+cell_neighbor_start[e]);
+
+    const unsigned int n_inner_face_batches = op.get_matrix_free().n_inner_face_batches();
+    const unsigned int n_face_batches = n_inner_face_batches+op.get_matrix_free().n_boundary_face_batches();
+    face_cells_interior.assign(n_face_batches*n_vect,n_cells_with_ghosts);
+    face_cells_exterior.assign(n_inner_face_batches*n_vect,n_cells_with_ghosts);
+    face_clusters_interior.assign(n_face_batches*n_vect,numbers::invalid_unsigned_int);
+    face_clusters_exterior.assign(n_inner_face_batches*n_vect,numbers::invalid_unsigned_int);
+    for (unsigned int f=0; f<n_face_batches; ++f)
+      for (unsigned int v=0; v<n_vect; ++v)
+        {
+          const unsigned int interior = op.get_matrix_free().get_face_info(f).cells_interior[v];
+          if (interior!=numbers::invalid_unsigned_int)
+            {
+              face_cells_interior[f*n_vect+v] = interior/n_vect;
+              face_clusters_interior[f*n_vect+v] = cell_cluster_ids[interior/n_vect];
+            }
+          if (f<n_inner_face_batches)
+            {
+              const unsigned int exterior = op.get_matrix_free().get_face_info(f).cells_exterior[v];
+              if (exterior!=numbers::invalid_unsigned_int)
+                {
+                  face_cells_exterior[f*n_vect+v] = exterior/n_vect;
+                  face_clusters_exterior[f*n_vect+v] = cell_cluster_ids[exterior/n_vect];
+                }
+            }
+        }
+
+    // compact lists of the cell batches of each cluster and of the face
+    // batches touching a cluster, which are the only candidates for
+    // evaluation when that cluster is updated
+    cluster_cells.clear();
+    cluster_faces.clear();
+    cluster_cells.resize(n_clusters);
+    cluster_faces.resize(n_clusters);
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+      cluster_cells[cell_cluster_ids[e]].push_back(e);
+    for (unsigned int f=0; f<n_face_batches; ++f)
+      {
+        std::vector<bool> touches_cluster(n_clusters,false);
+        for (unsigned int v=0; v<n_vect; ++v)
           {
-            cell_neighbor_index[n][v].resize(n_cells_with_ghosts);
-            cell_neighbor_active_cell_index[n][v].resize(n_cells_with_ghosts);
+            if (face_clusters_interior[f*n_vect+v]!=numbers::invalid_unsigned_int)
+              touches_cluster[face_clusters_interior[f*n_vect+v]] = true;
+            if (f<n_inner_face_batches && face_clusters_exterior[f*n_vect+v]!=numbers::invalid_unsigned_int)
+              touches_cluster[face_clusters_exterior[f*n_vect+v]] = true;
           }
+        for (unsigned int c=0; c<n_clusters; ++c)
+          if (touches_cluster[c])
+            cluster_faces[c].push_back(f);
       }
 
-    for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
-      for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-        for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
+    // the vectorization categories are strict and sorted by cluster, so the
+    // batches of a cluster form (almost) contiguous blocks in the matrix free
+    // numbering and the loops of a substep only need to cover these ranges
+    const unsigned int n_inner_faces = op.get_matrix_free().n_inner_face_batches();
+    cluster_cell_ranges.assign(n_clusters,std::make_pair(0U,0U));
+    cluster_inner_face_ranges.assign(n_clusters,std::make_pair(n_inner_faces,n_inner_faces));
+    cluster_boundary_face_ranges.assign(n_clusters,std::make_pair(n_inner_faces,n_inner_faces));
+    for (unsigned int c=0; c<n_clusters; ++c)
+      {
+        std::vector<unsigned int>::const_iterator owned_end =
+          std::lower_bound(cluster_cells[c].begin(),cluster_cells[c].end(),n_cells);
+        if (owned_end != cluster_cells[c].begin())
+          cluster_cell_ranges[c] = std::make_pair(cluster_cells[c].front(),*(owned_end-1)+1);
+
+        std::vector<unsigned int>::const_iterator inner_end =
+          std::lower_bound(cluster_faces[c].begin(),cluster_faces[c].end(),n_inner_faces);
+        if (inner_end != cluster_faces[c].begin())
+          cluster_inner_face_ranges[c] = std::make_pair(cluster_faces[c].front(),*(inner_end-1)+1);
+        if (inner_end != cluster_faces[c].end())
+          cluster_boundary_face_ranges[c] = std::make_pair(*inner_end,cluster_faces[c].back()+1);
+      }
+    evaluated_cluster = 0;
+
+    if (!Utilities::MPI::this_mpi_process(MPI_COMM_WORLD))
+      for (unsigned c=0; c<n_clusters; ++c)
+        std::cout<<"cluster  "<<c<<" spans "
+                 <<cluster_cell_ranges[c].second-cluster_cell_ranges[c].first<<" of "<<n_cells<<" cell batches and "
+                 <<cluster_inner_face_ranges[c].second-cluster_inner_face_ranges[c].first
+                 +cluster_boundary_face_ranges[c].second-cluster_boundary_face_ranges[c].first<<" of "
+                 <<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches()
+                 <<" face batches on rank 0"<<std::endl;
+
+    // restart the timings for the new layout
+    cluster_n_owned_cells.assign(n_clusters,0);
+    for (unsigned int e=0; e<n_cells; ++e)
+      ++cluster_n_owned_cells[cell_cluster_ids[e]];
+    cluster_update_time.assign(n_clusters,0.);
+    cluster_updated_batches.assign(n_clusters,0.);
+    step_time = 0.;
+
+    is_neighbor_of_update_cell.reinit(n_cells_with_ghosts+1);
+    update_cell_list.clear();
+    evaluate_cell_list.clear();
+    evaluate_face_list.clear();
+
+    // cells exchanged with the neighboring clusters in the multirate scheme
+    cluster_owned_cells.assign(n_clusters,std::vector<unsigned int>());
+    faster_interface_cells.assign(n_clusters,std::vector<unsigned int>());
+    slower_interface_cells.assign(n_clusters,std::vector<unsigned int>());
+    for (unsigned int e=0; e<n_cells; ++e)
+      {
+        cluster_owned_cells[cell_cluster_ids[e]].push_back(e);
+        if (cell_have_faster_neighbor[e])
+          faster_interface_cells[cell_cluster_ids[e]].push_back(e);
+        if (cell_have_slower_neighbor[e])
+          slower_interface_cells[cell_cluster_ids[e]].push_back(e);
+      }
+    cluster_start_values.assign(n_clusters,AlignedVector<VectorizedArray<Number> >());
+    cluster_start_derivatives.assign(n_clusters,AlignedVector<VectorizedArray<Number> >());
+    interface_history.assign(n_clusters,std::vector<AlignedVector<VectorizedArray<Number> > >());
+    interface_history_start.assign(n_clusters,0.);
+
+    setup_flux_memory(op);
+    setup_ghost_exchange(op);
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::setup_ghost_exchange(const Operator &op)
+  {
+    ghost_exchange_ranks.clear();
+    ghost_send_dofs.clear();
+    ghost_recv_dofs.clear();
+    set_ghost_clusters(0,n_clusters-1);
+    const unsigned int n_procs = Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD);
+    if (n_procs == 1)
+      return;
+
+    // the dofs of the ghost cell batches, requested from their owners by
+    // global index
+    const Utilities::MPI::Partitioner &partitioner = *op.get_matrix_free().get_vector_partitioner();
+    std::vector<types::global_dof_index> dof_indices(op.get_matrix_free().get_dof_handler(0).get_fe().dofs_per_cell);
+    std::map<unsigned int,std::vector<std::vector<types::global_dof_index> > > requested_dofs;
+    std::map<unsigned int,std::vector<std::vector<unsigned int> > > recv_dofs;
+    for (unsigned int e=n_cells; e<n_cells_with_ghosts; ++e)
+      for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
+        {
+          const typename DoFHandler<Operator::dimension>::cell_iterator cell = op.get_matrix_free().get_cell_iterator(e,v);
+          cell->get_dof_indices(dof_indices);
+          const unsigned int owner = cell->subdomain_id();
+          if (requested_dofs.find(owner) == requested_dofs.end())
+            {
+              requested_dofs[owner].resize(n_clusters);
+              recv_dofs[owner].resize(n_clusters);
+            }
+          for (unsigned int i=0; i<dof_indices.size(); ++i)
+            {
+              requested_dofs[owner][cell_cluster_ids[e]].push_back(dof_indices[i]);
+              recv_dofs[owner][cell_cluster_ids[e]].push_back(partitioner.global_to_local(dof_indices[i]));
+            }
+        }
+
+    // tell the owners how many dofs of each cluster we need
+    std::vector<unsigned int> send_counts(n_procs*n_clusters,0), recv_counts(n_procs*n_clusters,0);
+    for (typename std::map<unsigned int,std::vector<std::vector<types::global_dof_index> > >::const_iterator it=requested_dofs.begin(); it!=requested_dofs.end(); ++it)
+      for (unsigned int c=0; c<n_clusters; ++c)
+        send_counts[it->first*n_clusters+c] = it->second[c].size();
+    MPI_Alltoall(send_counts.data(),n_clusters,MPI_UNSIGNED,recv_counts.data(),n_clusters,MPI_UNSIGNED,MPI_COMM_WORLD);
+
+    const int tag = 1711;
+    std::map<unsigned int,std::vector<types::global_dof_index> > owned_requests;
+    std::vector<MPI_Request> requests;
+    for (unsigned int p=0; p<n_procs; ++p)
+      {
+        const unsigned int n_requested = std::accumulate(recv_counts.begin()+p*n_clusters,
+                                                         recv_counts.begin()+(p+1)*n_clusters,0U);
+        if (n_requested>0)
           {
-            cell_neighbor_index[n][v][e] = op.get_matrix_free().get_cell_iterator(e,v)->neighbor_index(n);
-            if (cell_neighbor_index[n][v][e] >= 0)
-              cell_neighbor_active_cell_index[n][v][e] = op.get_matrix_free().get_cell_iterator(e,v)->neighbor(n)->active_cell_index();
+            std::vector<types::global_dof_index> &indices = owned_requests[p];
+            indices.resize(n_requested);
+            requests.push_back(MPI_Request());
+            MPI_Irecv(indices.data(),indices.size()*sizeof(types::global_dof_index),MPI_BYTE,p,tag,MPI_COMM_WORLD,&requests.back());
           }
+      }
+    std::map<unsigned int,std::vector<types::global_dof_index> > flat_requested;
+    for (typename std::map<unsigned int,std::vector<std::vector<types::global_dof_index> > >::const_iterator it=requested_dofs.begin(); it!=requested_dofs.end(); ++it)
+      {
+        std::vector<types::global_dof_index> &indices = flat_requested[it->first];
+        for (unsigned int c=0; c<n_clusters; ++c)
+          indices.insert(indices.end(),it->second[c].begin(),it->second[c].end());
+        requests.push_back(MPI_Request());
+        MPI_Isend(indices.data(),indices.size()*sizeof(types::global_dof_index),MPI_BYTE,it->first,tag,MPI_COMM_WORLD,&requests.back());
+      }
+    MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    // store the lists of all ranks we exchange with in the same order
+    std::set<unsigned int> ranks;
+    for (typename std::map<unsigned int,std::vector<std::vector<unsigned int> > >::const_iterator it=recv_dofs.begin(); it!=recv_dofs.end(); ++it)
+      ranks.insert(it->first);
+    for (typename std::map<unsigned int,std::vector<types::global_dof_index> >::const_iterator it=owned_requests.begin(); it!=owned_requests.end(); ++it)
+      ranks.insert(it->first);
+    for (std::set<unsigned int>::const_iterator p=ranks.begin(); p!=ranks.end(); ++p)
+      {
+        ghost_exchange_ranks.push_back(*p);
+        ghost_send_dofs.push_back(std::vector<std::vector<unsigned int> >(n_clusters));
+        ghost_recv_dofs.push_back(std::vector<std::vector<unsigned int> >(n_clusters));
+        if (recv_dofs.find(*p) != recv_dofs.end())
+          ghost_recv_dofs.back() = recv_dofs[*p];
+        if (owned_requests.find(*p) != owned_requests.end())
+          {
+            const std::vector<types::global_dof_index> &indices = owned_requests[*p];
+            unsigned int offset = 0;
+            for (unsigned int c=0; c<n_clusters; ++c)
+              for (unsigned int i=0; i<recv_counts[*p*n_clusters+c]; ++i, ++offset)
+                {
+                  AssertThrow(partitioner.in_local_range(indices[offset]),
+                              ExcMessage("requested ghost dof is not owned by this rank"));
+                  ghost_send_dofs.back()[c].push_back(partitioner.global_to_local(indices[offset]));
+                }
+          }
+      }
+  }
 
-    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-      for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
-        for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
-          if (cell_neighbor_index[n][v][e] >= 0)
-            cell_neighbor_has_children[n][e][v] = op.get_matrix_free().get_cell_iterator(e,v)->neighbor(n)->has_children();
-
-    mf_faceinfo_cellsminus.clear();
-    mf_faceinfo_cellsplus.clear();
-    mf_faceinfo_cellsminus.resize(n_vect);
-    mf_faceinfo_cellsplus.resize(n_vect);
-    for (unsigned int v=0; v<n_vect; ++v)
+
+
+  template <typename Number>
+  void ClusterManager<Number>::update_ghost_values(const LinearAlgebra::distributed::Vector<Number> &vec) const
+  {
+    // like the ghost values of the vector itself, the ghost entries are
+    // considered mutable
+    LinearAlgebra::distributed::Vector<Number> &ghosted = const_cast<LinearAlgebra::distributed::Vector<Number> &>(vec);
+    const int tag = 1712;
+    std::vector<std::vector<Number> > send_data(ghost_exchange_ranks.size());
+    std::vector<std::vector<Number> > recv_data(ghost_exchange_ranks.size());
+    std::vector<MPI_Request> requests;
+    for (unsigned int p=0; p<ghost_exchange_ranks.size(); ++p)
       {
-        mf_faceinfo_cellsminus[v].resize(op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches());
-        mf_faceinfo_cellsplus[v].resize(op.get_matrix_free().n_inner_face_batches());
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          for (unsigned int i=0; i<ghost_send_dofs[p][c].size(); ++i)
+            send_data[p].push_back(ghosted.local_element(ghost_send_dofs[p][c][i]));
+        unsigned int n_recv = 0;
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          n_recv += ghost_recv_dofs[p][c].size();
+        recv_data[p].resize(n_recv);
+
+        if (!recv_data[p].empty())
+          {
+            requests.push_back(MPI_Request());
+            MPI_Irecv(recv_data[p].data(),recv_data[p].size()*sizeof(Number),MPI_BYTE,
+                      ghost_exchange_ranks[p],tag,MPI_COMM_WORLD,&requests.back());
+          }
+        if (!send_data[p].empty())
+          {
+            requests.push_back(MPI_Request());
+            MPI_Isend(send_data[p].data(),send_data[p].size()*sizeof(Number),MPI_BYTE,
+                      ghost_exchange_ranks[p],tag,MPI_COMM_WORLD,&requests.back());
+          }
+      }
+    if (!requests.empty())
+      MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    for (unsigned int p=0; p<ghost_exchange_ranks.size(); ++p)
+      {
+        unsigned int offset = 0;
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          for (unsigned int i=0; i<ghost_recv_dofs[p][c].size(); ++i, ++offset)
+            ghosted.local_element(ghost_recv_dofs[p][c][i]) = recv_data[p][offset];
       }
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::compress_add(LinearAlgebra::distributed::Vector<Number> &vec) const
+  {
+    // send the ghost contributions to the owners and clear them
+    const int tag = 1713;
+    std::vector<std::vector<Number> > send_data(ghost_exchange_ranks.size());
+    std::vector<std::vector<Number> > recv_data(ghost_exchange_ranks.size());
+    std::vector<MPI_Request> requests;
+    for (unsigned int p=0; p<ghost_exchange_ranks.size(); ++p)
+      {
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          for (unsigned int i=0; i<ghost_recv_dofs[p][c].size(); ++i)
+            {
+              send_data[p].push_back(vec.local_element(ghost_recv_dofs[p][c][i]));
+              vec.local_element(ghost_recv_dofs[p][c][i]) = 0.;
+            }
+        unsigned int n_recv = 0;
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          n_recv += ghost_send_dofs[p][c].size();
+        recv_data[p].resize(n_recv);
+
+        if (!recv_data[p].empty())
+          {
+            requests.push_back(MPI_Request());
+            MPI_Irecv(recv_data[p].data(),recv_data[p].size()*sizeof(Number),MPI_BYTE,
+                      ghost_exchange_ranks[p],tag,MPI_COMM_WORLD,&requests.back());
+          }
+        if (!send_data[p].empty())
+          {
+            requests.push_back(MPI_Request());
+            MPI_Isend(send_data[p].data(),send_data[p].size()*sizeof(Number),MPI_BYTE,
+                      ghost_exchange_ranks[p],tag,MPI_COMM_WORLD,&requests.back());
+          }
+      }
+    if (!requests.empty())
+      MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    for (unsigned int p=0; p<ghost_exchange_ranks.size(); ++p)
+      {
+        unsigned int offset = 0;
+        for (unsigned int c=ghost_clusters_begin; c<ghost_clusters_end; ++c)
+          for (unsigned int i=0; i<ghost_send_dofs[p][c].size(); ++i, ++offset)
+            vec.local_element(ghost_send_dofs[p][c][i]) += recv_data[p][offset];
+      }
+  }
+
 
-    for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(); ++f)
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::setup_flux_memory(const Operator &op)
+  {
+    // only cells next to a face between two clusters receive flux memory:
+    // locally owned cells with a faster or slower neighbor, and the ghost
+    // cells on the other side of a locally evaluated interface face
+    std::vector<bool> at_interface(n_cells_with_ghosts,false);
+    std::vector<std::bitset<n_vect> > ghost_lane_at_interface(n_cells_with_ghosts-n_cells);
+    for (unsigned int e=0; e<n_cells; ++e)
+      at_interface[e] = cell_have_faster_neighbor[e] || cell_have_slower_neighbor[e];
+    for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches(); ++f)
       for (unsigned int v=0; v<n_vect; ++v)
+        if (op.get_matrix_free().get_face_info(f).cells_interior[v]!=numbers::invalid_unsigned_int
+            && op.get_matrix_free().get_face_info(f).cells_exterior[v]!=numbers::invalid_unsigned_int)
+          {
+            const unsigned int minus = op.get_matrix_free().get_face_info(f).cells_interior[v];
+            const unsigned int plus = op.get_matrix_free().get_face_info(f).cells_exterior[v];
+            if (cell_cluster_ids[minus/n_vect]==cell_cluster_ids[plus/n_vect])
+              continue;
+            at_interface[minus/n_vect] = true;
+            at_interface[plus/n_vect] = true;
+            if (minus/n_vect>=n_cells)
+              ghost_lane_at_interface[minus/n_vect-n_cells][minus%n_vect] = true;
+            if (plus/n_vect>=n_cells)
+              ghost_lane_at_interface[plus/n_vect-n_cells][plus%n_vect] = true;
+          }
+
+    flux_memory_index.assign(n_cells_with_ghosts,numbers::invalid_unsigned_int);
+    n_flux_memory_batches = 0;
+    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+      if (at_interface[e])
+        flux_memory_index[e] = n_flux_memory_batches++;
+
+    flux_memory_send_cells.clear();
+    flux_memory_recv_cells.clear();
+    const unsigned int n_procs = Utilities::MPI::n_mpi_processes(MPI_COMM_WORLD);
+    if (n_procs == 1)
+      return;
+
+    // identify the cells across ranks by their first dof index
+    std::vector<types::global_dof_index> dof_indices(op.get_matrix_free().get_dof_handler(0).get_fe().dofs_per_cell);
+    std::map<unsigned int,std::vector<types::global_dof_index> > send_keys;
+    std::map<unsigned int,std::vector<std::pair<unsigned int,unsigned int> > > send_cells;
+    for (unsigned int e=n_cells; e<n_cells_with_ghosts; ++e)
+      for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
+        if (ghost_lane_at_interface[e-n_cells][v])
+          {
+            const typename DoFHandler<Operator::dimension>::cell_iterator cell = op.get_matrix_free().get_cell_iterator(e,v);
+            cell->get_dof_indices(dof_indices);
+            send_keys[cell->subdomain_id()].push_back(dof_indices[0]);
+            send_cells[cell->subdomain_id()].push_back(std::make_pair(flux_memory_index[e],v));
+          }
+
+    std::vector<unsigned int> send_counts(n_procs,0), recv_counts(n_procs,0);
+    for (typename std::map<unsigned int,std::vector<types::global_dof_index> >::const_iterator it=send_keys.begin(); it!=send_keys.end(); ++it)
+      send_counts[it->first] = it->second.size();
+    MPI_Alltoall(send_counts.data(),1,MPI_UNSIGNED,recv_counts.data(),1,MPI_UNSIGNED,MPI_COMM_WORLD);
+
+    const int tag = 1709;
+    std::map<unsigned int,std::vector<types::global_dof_index> > recv_keys;
+    std::vector<MPI_Request> requests;
+    for (unsigned int p=0; p<n_procs; ++p)
+      if (recv_counts[p]>0)
         {
-          mf_faceinfo_cellsminus[v][f] = op.get_matrix_free().get_face_info(f).cells_interior[v];
-          if (f<op.get_matrix_free().n_inner_face_batches())
-            mf_faceinfo_cellsplus[v][f] = op.get_matrix_free().get_face_info(f).cells_exterior[v];
+          std::vector<types::global_dof_index> &keys = recv_keys[p];
+          keys.resize(recv_counts[p]);
+          requests.push_back(MPI_Request());
+          MPI_Irecv(keys.data(),keys.size()*sizeof(types::global_dof_index),MPI_BYTE,p,tag,MPI_COMM_WORLD,&requests.back());
         }
+    for (typename std::map<unsigned int,std::vector<types::global_dof_index> >::iterator it=send_keys.begin(); it!=send_keys.end(); ++it)
+      {
+        requests.push_back(MPI_Request());
+        MPI_Isend(it->second.data(),it->second.size()*sizeof(types::global_dof_index),MPI_BYTE,it->first,tag,MPI_COMM_WORLD,&requests.back());
+      }
+    MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    std::map<types::global_dof_index,std::pair<unsigned int,unsigned int> > owned_interface_cells;
+    for (unsigned int e=0; e<n_cells; ++e)
+      if (at_interface[e])
+        for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
+          {
+            op.get_matrix_free().get_cell_iterator(e,v)->get_dof_indices(dof_indices);
+            owned_interface_cells[dof_indices[0]] = std::make_pair(flux_memory_index[e],v);
+          }
+
+    for (typename std::map<unsigned int,std::vector<std::pair<unsigned int,unsigned int> > >::const_iterator it=send_cells.begin(); it!=send_cells.end(); ++it)
+      flux_memory_send_cells.push_back(*it);
+    for (typename std::map<unsigned int,std::vector<types::global_dof_index> >::const_iterator it=recv_keys.begin(); it!=recv_keys.end(); ++it)
+      {
+        flux_memory_recv_cells.push_back(std::make_pair(it->first,std::vector<std::pair<unsigned int,unsigned int> >()));
+        for (unsigned int i=0; i<it->second.size(); ++i)
+          {
+            typename std::map<types::global_dof_index,std::pair<unsigned int,unsigned int> >::const_iterator
+            cell = owned_interface_cells.find(it->second[i]);
+            AssertThrow(cell!=owned_interface_cells.end(),
+                        ExcMessage("ghost cell at a cluster interface is not at an interface on its owner"));
+            flux_memory_recv_cells.back().second.push_back(cell->second);
+          }
+      }
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::exchange_flux_memory(AlignedVector<VectorizedArray<Number> > &flux_memory,
+                                                    const unsigned int                        dofs_per_cell) const
+  {
+    // send the contributions of the ghost cells and clear them
+    const int tag = 1710;
+    std::vector<std::vector<Number> > send_data(flux_memory_send_cells.size());
+    std::vector<std::vector<Number> > recv_data(flux_memory_recv_cells.size());
+    std::vector<MPI_Request> requests(flux_memory_send_cells.size()+flux_memory_recv_cells.size());
+    for (unsigned int p=0; p<flux_memory_recv_cells.size(); ++p)
+      {
+        recv_data[p].resize(flux_memory_recv_cells[p].second.size()*dofs_per_cell);
+        MPI_Irecv(recv_data[p].data(),recv_data[p].size()*sizeof(Number),MPI_BYTE,
+                  flux_memory_recv_cells[p].first,tag,MPI_COMM_WORLD,&requests[p]);
+      }
+    for (unsigned int p=0; p<flux_memory_send_cells.size(); ++p)
+      {
+        const std::vector<std::pair<unsigned int,unsigned int> > &cells = flux_memory_send_cells[p].second;
+        send_data[p].resize(cells.size()*dofs_per_cell);
+        for (unsigned int i=0; i<cells.size(); ++i)
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            {
+              VectorizedArray<Number> &entry = flux_memory[cells[i].first*dofs_per_cell+j];
+              send_data[p][i*dofs_per_cell+j] = entry[cells[i].second];
+              entry[cells[i].second] = 0.;
+            }
+        MPI_Isend(send_data[p].data(),send_data[p].size()*sizeof(Number),MPI_BYTE,
+                  flux_memory_send_cells[p].first,tag,MPI_COMM_WORLD,&requests[flux_memory_recv_cells.size()+p]);
+      }
+    if (!requests.empty())
+      MPI_Waitall(requests.size(),requests.data(),MPI_STATUSES_IGNORE);
+
+    // add them to the owned cells
+    for (unsigned int p=0; p<flux_memory_recv_cells.size(); ++p)
+      {
+        const std::vector<std::pair<unsigned int,unsigned int> > &cells = flux_memory_recv_cells[p].second;
+        for (unsigned int i=0; i<cells.size(); ++i)
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            flux_memory[cells[i].first*dofs_per_cell+j][cells[i].second] += recv_data[p][i*dofs_per_cell+j];
+      }
   }
 
 
@@ -538,12 +1276,18 @@ namespace HDG_WE
                                                  const LinearAlgebra::distributed::Vector<Number>  &src,
                                                  LinearAlgebra::distributed::Vector<Number>        &dst) const
   {
-    state = src;
-    dst = 0;
+    Timer step_timer;
+
+    // the state is advanced in place in dst, which may alias src
+    if (&dst != &src)
+      dst = src;
+    LinearAlgebra::distributed::Vector<Number> &state = dst;
 
     if (use_ader_post)
       {
-        // standard reconstruction:
+        // standard reconstruction. Unlike the fused ADER predictor sweep,
+        // this is a separate evaluation on the whole vector, because the
+        // clusters are predicted at different times below
         op.apply(state,improvedgraddiv);
       }
 
@@ -551,6 +1295,11 @@ namespace HDG_WE
     for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
       cell_timelevels[e] = cluster_timelevels[cell_cluster_ids[e]];
 
+    // the updates run one after the other in cluster_update_order. Updates of
+    // clusters that are not neighbors would be independent in principle, but
+    // all of them work on the cell and face flags, masks and time bounds
+    // stored in this class, and their ghost exchanges and flux memory
+    // transfers must be issued in the same order on all ranks
     for (unsigned int cycle = 0; cycle<n_updates; ++cycle)
       {
         // we want to update the elements of cluster cluster_update_order[cycle]
@@ -566,13 +1315,9 @@ namespace HDG_WE
           }
         is_fluxmemory_considered = true;
 
-        for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-          {
-            if (cell_cluster_ids[e]==actual_cluster)
-              update_cell[e] = true;
-            else
-              update_cell[e] = false;
-          }
+        clear_cells(update_cell,update_cell_list);
+        for (unsigned int i=0; i<cluster_cells[actual_cluster].size(); ++i)
+          mark_cell(update_cell,update_cell_list,cluster_cells[actual_cluster][i]);
 
         double faster_cluster_time = 0.0;
         if (actual_cluster>0)
@@ -608,21 +1353,24 @@ namespace HDG_WE
         dt = std::min(cluster_timestepmultiples[actual_cluster]*fastest_time_step,
                       op.get_time_control().get_time()-cluster_timelevels[actual_cluster]);
 
-        update_elements(op,dst,state,actual_cluster);
+        Timer cluster_timer;
+        update_elements(op,state,actual_cluster);
 
         // update time level of cluster
         cluster_timelevels[actual_cluster] = cluster_update_times[cycle][1];
 
-        // update cell times
-        for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-          cell_timelevels[e] = cluster_timelevels[cell_cluster_ids[e]];
+        // update cell times, only the cells of the updated cluster changed
+        for (unsigned int i=0; i<cluster_cells[actual_cluster].size(); ++i)
+          cell_timelevels[cluster_cells[actual_cluster][i]] = cluster_timelevels[actual_cluster];
 
         // in case we want superconvergence, we need to do the reconstruction step as explained in the paper
         if (use_ader_post)
           {
-            // init
+            // init, the neighboring cells are advanced in the state itself and
+            // restored after the reconstruction
             is_fluxmemory_considered = false;
-            temporary_recon_state = state;
+            saved_cells.clear();
+            saved_values.clear();
 
             // current cluster advanced in time
             actual_cluster_time = cluster_timelevels[actual_cluster];
@@ -630,37 +1378,10 @@ namespace HDG_WE
             // which cells do we have to update to be able to perform reconstruction
             // all cells who are neighbor of actual cluster and  have lower or higher time level
             // start with faster cluster:
-            std::vector<bool> temp_faster(n_cells_with_ghosts);
-            std::vector<bool> temp_slower(n_cells_with_ghosts);
             if (actual_cluster>0)
               if (std::abs(actual_cluster_time-cluster_timelevels[actual_cluster-1])>relative_tolerance*fastest_time_step)
                 {
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    {
-                      if (cell_cluster_ids[e]==actual_cluster-1 && cell_have_slower_neighbor[e])
-                        temp_faster[e] = true;
-                      else
-                        temp_faster[e] = false;
-                    }
-                  // expand this selection by the neighbors of those already set (later we need neighbor of neighbor info!)
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    update_cell[e]=false;
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    {
-                      for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
-                        for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
-                          if (cell_neighbor_index[n][v][e]>=0)
-                            {
-                              if (temp_faster[mf_index[cell_neighbor_active_cell_index[n][v][e]]] && cell_cluster_ids[e]==actual_cluster-1)
-                                update_cell[e]=true;
-                              else
-                                update_cell[e]=false;
-                            }
-                    }
-                  // combine both
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    update_cell[e] = update_cell[e] || temp_faster[e];
-                  temp_faster = update_cell;
+                  select_interface_cells(actual_cluster-1,cell_have_slower_neighbor);
 
                   t1fa = cluster_timelevels[actual_cluster-1];
                   t2fa = actual_cluster_time;
@@ -673,39 +1394,15 @@ namespace HDG_WE
 
                   dt = t2fa-t1fa;
 
-                  update_elements(op,dst,temporary_recon_state,actual_cluster-1,false);
+                  save_update_cells(op,state);
+                  update_elements(op,state,actual_cluster-1,false);
                 }
 
             // slower cluster
             if (actual_cluster<n_clusters-1)
               if (std::abs(actual_cluster_time-cluster_timelevels[actual_cluster+1])>relative_tolerance*fastest_time_step)
                 {
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    {
-                      if (cell_cluster_ids[e]==actual_cluster+1 && cell_have_faster_neighbor[e])
-                        temp_slower[e] = true;
-                      else
-                        temp_slower[e] = false;
-                    }
-
-                  // expand this selection by the neighbors of those already set (later we need neighbor of neighbor info!)
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    update_cell[e] = false;
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    {
-                      for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
-                        for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
-                          if (cell_neighbor_index[n][v][e]>=0)
-                            if (temp_slower[mf_index[cell_neighbor_active_cell_index[n][v][e]]] && cell_cluster_ids[e]==actual_cluster+1)
-                              {
-                                update_cell[e]=true;
-                              }
-                    }
-
-                  // combine both
-                  for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-                    update_cell[e] = (update_cell[e] || temp_slower[e]);
-                  temp_slower = update_cell;
+                  select_interface_cells(actual_cluster+1,cell_have_faster_neighbor);
 
                   t1fa = cluster_timelevels[actual_cluster+1];
                   t2fa = actual_cluster_time;
@@ -718,56 +1415,20 @@ namespace HDG_WE
 
                   dt = t2fa-t1fa;
 
-                  update_elements(op,dst,temporary_recon_state,actual_cluster+1,false);
+                  save_update_cells(op,state);
+                  update_elements(op,state,actual_cluster+1,false);
                 }
             // now, the neighboring elements are at the required time level
 
             // reconstruction:
-            for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-              {
-                if (cell_cluster_ids[e]==actual_cluster)
-                  evaluate_cell[e] = true;
-                else
-                  evaluate_cell[e] = false;
-              }
-
-            for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(); ++f)
-              {
-                evaluate_face[f] = false;
-                phi_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                phi_neighbor_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                if (f<op.get_matrix_free().n_inner_face_batches())
-                  {
-                    for (unsigned int v=0; v<Operator::n_vect; ++v)
-                      {
-                        if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int && mf_faceinfo_cellsplus[v][f]!=numbers::invalid_unsigned_int)
-                          if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]
-                              || evaluate_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect])
-                            {
-                              evaluate_face[f] = true;
-                              // set masks
-                              if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect])
-                                phi_to_dst[f][v] = true;
-                              if (evaluate_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect])
-                                phi_neighbor_to_dst[f][v] = true;
-                            }
-                      }
-                  }
-                else
-                  {
-                    for (unsigned int v=0; v<Operator::n_vect; ++v)
-                      {
-                        if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int)
-                          if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect])
-                            {
-                              evaluate_face[f] = true;
-                              phi_to_dst[f][v] = true;
-                            }
-                      }
-                  }
-              }
-            op.reconstruct_div_grad(temporary_recon_state,improvedgraddiv);
+            select_evaluate_cells(op,actual_cluster,cluster_cells[actual_cluster]);
+            op.reconstruct_div_grad(state,improvedgraddiv);
+            op.copy_buffer_to_cells(saved_cells,saved_values,state);
           }
+
+        // measured cost of the update including the reconstruction
+        cluster_update_time[actual_cluster] += cluster_timer.wall_time();
+        cluster_updated_batches[actual_cluster] += cluster_n_owned_cells[actual_cluster];
       } // for(unsigned int cycle = 0; cycle<n_updates; ++cycle)
 
     // update the update times
@@ -775,8 +1436,313 @@ namespace HDG_WE
       for (unsigned int n=0; n<2 ; ++n)
         cluster_update_times[c][n] += op.get_time_control().get_time_step();
 
-    // tell the time integrator about the new state
-    dst = state;
+    step_time += step_timer.wall_time();
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::perform_multirate_time_step(const Operator &op,
+                                                           const std::vector<double> &stage_factors,
+                                                           const std::vector<double> &weights,
+                                                           LinearAlgebra::distributed::Vector<Number> &state) const
+  {
+    AssertThrow(nested_time_steps,ExcMessage("the multirate scheme needs nested cluster time steps"));
+    AssertDimension(stage_factors.size()+1,weights.size());
+    Timer step_timer;
+
+    // the time control already points to the end of the step
+    const Number start_time = op.get_time_control().get_time()-op.get_time_control().get_time_step();
+    for (unsigned int c=0; c<n_clusters; ++c)
+      cluster_timelevels[c] = start_time;
+
+    // stage times relative to the step size: stage s+1 starts from the
+    // weighted derivatives up to s-1 plus a_{s+1,s} times the derivative s
+    std::vector<double> stage_times(weights.size(),0.);
+    double weight_sum = 0.;
+    for (unsigned int s=1; s<weights.size(); ++s)
+      {
+        stage_times[s] = weight_sum+stage_factors[s-1];
+        weight_sum += weights[s-1];
+      }
+
+    // the slowest cluster recursively subcycles all faster ones
+    advance_cluster(op,n_clusters-1,stage_factors,weights,stage_times,state);
+
+    step_time += step_timer.wall_time();
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::advance_cluster(const Operator &op,
+                                               const unsigned int cluster,
+                                               const std::vector<double> &stage_factors,
+                                               const std::vector<double> &weights,
+                                               const std::vector<double> &stage_times,
+                                               LinearAlgebra::distributed::Vector<Number> &state) const
+  {
+    const Number step = cluster_timestepmultiples[cluster]*fastest_time_step;
+    const Number start_time = cluster_timelevels[cluster];
+    const unsigned int n_stages = weights.size();
+    Timer cluster_timer;
+
+    // the derivative of the first stage only involves values at the start of
+    // the step, so evaluate it before the faster cluster moves on. At the
+    // interface, it extrapolates this cluster for the faster one.
+    evaluate_cluster_derivative(op,cluster,start_time,state,start_derivative);
+    cluster_start_values[cluster].clear();
+    cluster_start_derivatives[cluster].clear();
+    op.copy_cells_to_buffer(faster_interface_cells[cluster],state,cluster_start_values[cluster]);
+    op.copy_cells_to_buffer(faster_interface_cells[cluster],start_derivative,cluster_start_derivatives[cluster]);
+    double update_time = cluster_timer.wall_time();
+
+    if (cluster>0)
+      {
+        // subcycle the faster cluster and keep its values at the interface
+        // after each of its steps
+        const unsigned int n_substeps = cluster_timestepmultiples[cluster]/cluster_timestepmultiples[cluster-1];
+        interface_history_start[cluster-1] = start_time;
+        interface_history[cluster-1].resize(n_substeps+1);
+        interface_history[cluster-1][0].clear();
+        op.copy_cells_to_buffer(slower_interface_cells[cluster-1],state,interface_history[cluster-1][0]);
+        for (unsigned int i=0; i<n_substeps; ++i)
+          {
+            advance_cluster(op,cluster-1,stage_factors,weights,stage_times,state);
+            interface_history[cluster-1][i+1].clear();
+            op.copy_cells_to_buffer(slower_interface_cells[cluster-1],state,interface_history[cluster-1][i+1]);
+          }
+      }
+
+    // stages of the two-register scheme on the cells of this cluster, the
+    // stage values are kept in state and the accumulated update in
+    // stage_accumulator
+    cluster_timer.restart();
+    const std::vector<unsigned int> &cells = cluster_owned_cells[cluster];
+    op.update_stage(cells,start_derivative,step*(n_stages>1 ? stage_factors[0] : 0.),step*weights[0],
+                    true,n_stages==1,state,stage_accumulator);
+    for (unsigned int s=1; s<n_stages; ++s)
+      {
+        evaluate_cluster_derivative(op,cluster,start_time+stage_times[s]*step,state,stage_derivative);
+        op.update_stage(cells,stage_derivative,step*(s+1<n_stages ? stage_factors[s] : 0.),step*weights[s],
+                        false,s+1==n_stages,state,stage_accumulator);
+      }
+    cluster_timelevels[cluster] = start_time+step;
+
+    // measured cost of the update without the subcycles
+    cluster_update_time[cluster] += update_time+cluster_timer.wall_time();
+    cluster_updated_batches[cluster] += cluster_n_owned_cells[cluster];
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::evaluate_cluster_derivative(const Operator &op,
+                                                           const unsigned int cluster,
+                                                           const Number time,
+                                                           LinearAlgebra::distributed::Vector<Number> &state,
+                                                           LinearAlgebra::distributed::Vector<Number> &derivative) const
+  {
+    // the faster cluster is ahead, interpolate linearly between its steps
+    const bool interpolate_faster = cluster>0 &&
+                                    std::abs(cluster_timelevels[cluster-1]-time)>relative_tolerance*fastest_time_step;
+    if (interpolate_faster)
+      {
+        const std::vector<AlignedVector<VectorizedArray<Number> > > &history = interface_history[cluster-1];
+        Assert(history.size()>1,ExcMessage("faster cluster has not been subcycled"));
+        const Number position = (time-interface_history_start[cluster-1])/(cluster_timestepmultiples[cluster-1]*fastest_time_step);
+        const unsigned int i = std::min(static_cast<unsigned int>(std::max(position,Number(0.))),
+                                        static_cast<unsigned int>(history.size()-2));
+        const Number theta = position-i;
+        op.combine_buffers_to_cells(slower_interface_cells[cluster-1],history[i],1.-theta,history[i+1],theta,state);
+      }
+
+    // the slower cluster is behind, extrapolate it from the start of its step
+    const bool extrapolate_slower = cluster<n_clusters-1 &&
+                                    std::abs(cluster_timelevels[cluster+1]-time)>relative_tolerance*fastest_time_step;
+    if (extrapolate_slower)
+      op.combine_buffers_to_cells(faster_interface_cells[cluster+1],cluster_start_values[cluster+1],1.,
+                                  cluster_start_derivatives[cluster+1],time-cluster_timelevels[cluster+1],state);
+
+    select_evaluate_cells(op,cluster,cluster_cells[cluster]);
+    op.evaluate_selected_cells(state,derivative);
+
+    // restore the neighbors to their current time level
+    if (interpolate_faster)
+      op.copy_buffer_to_cells(slower_interface_cells[cluster-1],interface_history[cluster-1].back(),state);
+    if (extrapolate_slower)
+      op.copy_buffer_to_cells(faster_interface_cells[cluster+1],cluster_start_values[cluster+1],state);
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::select_evaluate_cells(const Operator &op,
+                                                     const unsigned int cluster,
+                                                     const std::vector<unsigned int> &cells) const
+  {
+    evaluated_cluster = cluster;
+    clear_cells(evaluate_cell,evaluate_cell_list);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      mark_cell(evaluate_cell,evaluate_cell_list,cells[i]);
+    set_ghost_clusters(std::max(cluster,1U)-1,std::min(cluster+1,n_clusters-1));
+
+    clear_faces();
+    for (unsigned int i=0; i<cluster_faces[cluster].size(); ++i)
+      {
+        const unsigned int f = cluster_faces[cluster][i];
+        const std::bitset<n_vect> minus = face_flags(evaluate_cell,face_cells_interior,f);
+        const std::bitset<n_vect> plus = f<op.get_matrix_free().n_inner_face_batches() ?
+                                         face_flags(evaluate_cell,face_cells_exterior,f) : std::bitset<n_vect>();
+        if ((minus|plus).any())
+          {
+            mark_face(f);
+            // set masks
+            phi_to_dst[f] |= minus;
+            phi_neighbor_to_dst[f] |= plus;
+          }
+      }
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::mark_cell(CellFlags                 &flags,
+                                         std::vector<unsigned int> &list,
+                                         const unsigned int         cell) const
+  {
+    if (!flags[cell])
+      {
+        flags.set(cell);
+        list.push_back(cell);
+      }
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::clear_cells(CellFlags                 &flags,
+                                           std::vector<unsigned int> &list) const
+  {
+    for (unsigned int i=0; i<list.size(); ++i)
+      flags.reset(list[i]);
+    list.clear();
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::mark_face(const unsigned int face) const
+  {
+    if (!evaluate_face[face])
+      {
+        evaluate_face[face] = true;
+        evaluate_face_list.push_back(face);
+      }
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::clear_faces() const
+  {
+    for (unsigned int i=0; i<evaluate_face_list.size(); ++i)
+      {
+        const unsigned int f = evaluate_face_list[i];
+        evaluate_face[f] = false;
+        phi_to_dst[f].reset();
+        phi_neighbor_to_dst[f].reset();
+        phi_to_fluxmemory[f].reset();
+        phi_neighbor_to_fluxmemory[f].reset();
+      }
+    evaluate_face_list.clear();
+  }
+
+
+
+  template <typename Number>
+  void ClusterManager<Number>::select_interface_cells(const unsigned int  cluster,
+                                                      const CellFlags    &at_interface) const
+  {
+    // cells of the given cluster at the interface to the actual cluster
+    clear_cells(update_cell,update_cell_list);
+    for (unsigned int i=0; i<cluster_cells[cluster].size(); ++i)
+      if (at_interface[cluster_cells[cluster][i]])
+        mark_cell(update_cell,update_cell_list,cluster_cells[cluster][i]);
+
+    // expand this selection by their neighbors in the same cluster (later we
+    // need neighbor of neighbor info!)
+    const unsigned int n_interface_cells = update_cell_list.size();
+    for (unsigned int i=0; i<n_interface_cells; ++i)
+      {
+        const unsigned int cell = update_cell_list[i];
+        for (unsigned int j=cell_neighbor_start[cell]; j<cell_neighbor_start[cell+1]; ++j)
+          if (cell_cluster_ids[cell_neighbor_list[j]]==cluster)
+            mark_cell(update_cell,update_cell_list,cell_neighbor_list[j]);
+      }
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::save_update_cells(const Operator &op,
+                                                 const LinearAlgebra::distributed::Vector<Number> &state) const
+  {
+    // only locally owned cells are changed by the update
+    std::vector<unsigned int> owned_cells;
+    for (unsigned int i=0; i<update_cell_list.size(); ++i)
+      if (update_cell_list[i]<n_cells)
+        owned_cells.push_back(update_cell_list[i]);
+    op.copy_cells_to_buffer(owned_cells,state,saved_values);
+    saved_cells.insert(saved_cells.end(),owned_cells.begin(),owned_cells.end());
+  }
+
+
+
+  template <typename Number>
+  template <typename Operator>
+  void ClusterManager<Number>::setup_interface_faces(const Operator     &op,
+                                                     const unsigned int  actual_cluster,
+                                                     const bool          write_to_fluxmemory) const
+  {
+    // setup the face list that need evaluation (if face is in between update
+    // cell and neighbor cluster), also, setup the masks for the write
+    // functions. There is no contribution from boundary faces in this stage.
+    clear_faces();
+    for (unsigned int i=0; i<cluster_faces[actual_cluster].size(); ++i)
+      {
+        const unsigned int f = cluster_faces[actual_cluster][i];
+        if (f>=op.get_matrix_free().n_inner_face_batches())
+          continue;
+
+        // lanes between an evaluated cell of the actual cluster and an
+        // evaluated neighbor of an update cell in the other cluster
+        const std::bitset<n_vect> evaluated = face_flags(evaluate_cell,face_cells_interior,f)
+                                              & face_flags(evaluate_cell,face_cells_exterior,f);
+        const std::bitset<n_vect> minus_in_cluster = face_cluster_flags(face_clusters_interior,f,actual_cluster);
+        const std::bitset<n_vect> plus_in_cluster = face_cluster_flags(face_clusters_exterior,f,actual_cluster);
+        const std::bitset<n_vect> minus_side = evaluated & minus_in_cluster & ~plus_in_cluster
+                                               & face_flags(is_neighbor_of_update_cell,face_cells_exterior,f);
+        const std::bitset<n_vect> plus_side = evaluated & ~minus_in_cluster & plus_in_cluster
+                                              & face_flags(is_neighbor_of_update_cell,face_cells_interior,f);
+        if ((minus_side|plus_side).any())
+          {
+            mark_face(f);
+            // set masks, the side in the actual cluster is updated
+            phi_to_dst[f] |= minus_side;
+            phi_neighbor_to_dst[f] |= plus_side;
+            if (write_to_fluxmemory)
+              {
+                phi_neighbor_to_fluxmemory[f] |= minus_side;
+                phi_to_fluxmemory[f] |= plus_side;
+              }
+          }
+      }
   }
 
 
@@ -784,7 +1750,6 @@ namespace HDG_WE
   template <typename Number>
   template <typename Operator>
   void ClusterManager<Number>::update_elements(const Operator &op,
-                                               LinearAlgebra::distributed::Vector<Number> &dst,
                                                LinearAlgebra::distributed::Vector<Number> &local_state,
                                                const unsigned int actual_cluster,
                                                const bool write_to_fluxmemory) const
@@ -792,40 +1757,24 @@ namespace HDG_WE
     double actual_cluster_time = cluster_timelevels[actual_cluster];
 
     // security  checks
-    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+    for (unsigned int i=0; i<update_cell_list.size(); ++i)
       {
-        if (update_cell[e] == true && cell_cluster_ids[e]!=actual_cluster)
+        if (cell_cluster_ids[update_cell_list[i]]!=actual_cluster)
           Assert(false,ExcMessage("it is not allowed to call update elements on cells of differing cluster!"));
-        if (update_cell[e] == true)
-          if (cell_timelevels[e] != actual_cluster_time)
-            Assert(false,ExcMessage("it is not allowed to call update elements on cells of differing time level!"));
+        if (cell_timelevels[update_cell_list[i]] != actual_cluster_time)
+          Assert(false,ExcMessage("it is not allowed to call update elements on cells of differing time level!"));
       }
+    (void)actual_cluster_time;
+    evaluated_cluster = actual_cluster;
 
-    // fill neighbor vector
-    std::vector<bool> is_neighbor_of_update_cell(n_cells_with_ghosts,false);
-    for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
+    // fill neighbor list
+    std::vector<unsigned int> neighbor_cells;
+    for (unsigned int i=0; i<update_cell_list.size(); ++i)
       {
-        if (update_cell[e] == false)
-          {
-            for (unsigned int v=0; v<op.get_matrix_free().n_components_filled(e); ++v)
-              for (unsigned int n=0; n<GeometryInfo<Operator::dimension>::faces_per_cell; ++n)
-                if (cell_neighbor_index[n][v][e]>=0)
-                  {
-                    if (cell_neighbor_has_children[n][e][v])
-                      {
-                        for (unsigned int subfaces = 0; subfaces < GeometryInfo<Operator::dimension>::max_children_per_face; ++subfaces)
-                          {
-                            if (update_cell[mf_index[op.get_matrix_free().get_cell_iterator(e,v)->neighbor_child_on_subface(n,subfaces)->active_cell_index()]])
-                              is_neighbor_of_update_cell[e] = true;
-                          }
-                      }
-                    else
-                      {
-                        if (update_cell[mf_index[cell_neighbor_active_cell_index[n][v][e]]])
-                          is_neighbor_of_update_cell[e] = true;
-                      }
-                  }
-          }
+        const unsigned int cell = update_cell_list[i];
+        for (unsigned int j=cell_neighbor_start[cell]; j<cell_neighbor_start[cell+1]; ++j)
+          if (!update_cell[cell_neighbor_list[j]])
+            mark_cell(is_neighbor_of_update_cell,neighbor_cells,cell_neighbor_list[j]);
       }
 
     // contribution from the faster cluster
@@ -839,65 +1788,19 @@ namespace HDG_WE
           {
             // setup the element list that need evaluation (all of update_cell who have faster neighbor
             // and all of actual_cluster-1 who are neighbor of update_cell)
-            for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-              {
-                if (cell_cluster_ids[e]==actual_cluster && cell_have_faster_neighbor[e] && update_cell[e])
-                  evaluate_cell[e] = true;
-                else if (cell_cluster_ids[e]==actual_cluster-1 && cell_have_slower_neighbor[e] && is_neighbor_of_update_cell[e])
-                  evaluate_cell[e] = true;
-                else
-                  evaluate_cell[e] = false;
-              }
+            clear_cells(evaluate_cell,evaluate_cell_list);
+            for (unsigned int i=0; i<update_cell_list.size(); ++i)
+              if (cell_have_faster_neighbor[update_cell_list[i]])
+                mark_cell(evaluate_cell,evaluate_cell_list,update_cell_list[i]);
+            for (unsigned int i=0; i<neighbor_cells.size(); ++i)
+              if (cell_cluster_ids[neighbor_cells[i]]==actual_cluster-1 && cell_have_slower_neighbor[neighbor_cells[i]])
+                mark_cell(evaluate_cell,evaluate_cell_list,neighbor_cells[i]);
+
+            setup_interface_faces(op,actual_cluster,write_to_fluxmemory);
+            set_ghost_clusters(actual_cluster-1,actual_cluster);
 
-            // setup the face list that need evaluation (if face is in between update cell and faster cluster)
-            // also, setup the masks for the write functions
-            for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(); ++f)
-              {
-                evaluate_face[f] = false;
-                phi_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                phi_neighbor_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                phi_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
-                phi_neighbor_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
-                // inner faces
-                if (f<op.get_matrix_free().n_inner_face_batches())
-                  {
-                    for (unsigned int v=0; v<Operator::n_vect; ++v)
-                      if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int && mf_faceinfo_cellsplus[v][f]!=numbers::invalid_unsigned_int)
-                        if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] && evaluate_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect])
-                          {
-                            // set face evaluation
-                            if (  ( cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]==actual_cluster
-                                    && cell_cluster_ids[mf_faceinfo_cellsplus[v][f]/Operator::n_vect]!=actual_cluster
-                                    && is_neighbor_of_update_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect] )
-                                  ||
-                                  ( cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]!=actual_cluster
-                                    && cell_cluster_ids[mf_faceinfo_cellsplus[v][f]/Operator::n_vect]==actual_cluster
-                                    && is_neighbor_of_update_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] ) )
-                              {
-                                evaluate_face[f] = true;
-                                // set masks
-                                if (cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]==actual_cluster)
-                                  {
-                                    phi_to_dst[f][v] = true;
-                                    if (write_to_fluxmemory)
-                                      phi_neighbor_to_fluxmemory[f][v] = true;
-                                  }
-                                else
-                                  {
-                                    if (write_to_fluxmemory)
-                                      phi_to_fluxmemory[f][v] = true;
-                                    phi_neighbor_to_dst[f][v] = true;
-                                  }
-                              }
-                          }
-                  }
-                else // boundary faces
-                  {
-                    // no contribution from boundary faces in this stage
-                  }
-              }
             // do first ader
-            op.evaluate_cells_and_faces_first_ader(local_state,dst);
+            op.evaluate_cells_and_faces_first_ader(local_state,face_contributions);
           }
       }
 
@@ -912,67 +1815,19 @@ namespace HDG_WE
           {
             // setup the element list that need evaluation (all of actual_cluster who have slower neighbor
             // and all of actual_cluster+1 who have faster neighbor)
-            for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-              {
-                if (cell_cluster_ids[e]==actual_cluster && cell_have_slower_neighbor[e] && update_cell[e])
-                  evaluate_cell[e] = true;
-                else if (cell_cluster_ids[e]==actual_cluster+1 && cell_have_faster_neighbor[e] && is_neighbor_of_update_cell[e])
-                  evaluate_cell[e] = true;
-                else
-                  evaluate_cell[e] = false;
-              }
+            clear_cells(evaluate_cell,evaluate_cell_list);
+            for (unsigned int i=0; i<update_cell_list.size(); ++i)
+              if (cell_have_slower_neighbor[update_cell_list[i]])
+                mark_cell(evaluate_cell,evaluate_cell_list,update_cell_list[i]);
+            for (unsigned int i=0; i<neighbor_cells.size(); ++i)
+              if (cell_cluster_ids[neighbor_cells[i]]==actual_cluster+1 && cell_have_faster_neighbor[neighbor_cells[i]])
+                mark_cell(evaluate_cell,evaluate_cell_list,neighbor_cells[i]);
+
+            setup_interface_faces(op,actual_cluster,write_to_fluxmemory);
+            set_ghost_clusters(actual_cluster,actual_cluster+1);
 
-            // setup the face list that need evaluation (if face is in between actual cluster and slower cluster)
-            // also, setup the masks for the write functions
-            for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(); ++f)
-              {
-                evaluate_face[f] = false;
-                phi_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                phi_neighbor_to_dst[f] = std::bitset<Operator::n_vect>(false);
-                phi_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
-                phi_neighbor_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
-                // inner faces
-                if (f<op.get_matrix_free().n_inner_face_batches())
-                  {
-                    for (unsigned int v=0; v<Operator::n_vect; ++v)
-                      if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int && mf_faceinfo_cellsplus[v][f]!=numbers::invalid_unsigned_int)
-                        {
-                          if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] && evaluate_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect])
-                            {
-                              // set face evaluation
-                              if (  ( cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]==actual_cluster
-                                      && cell_cluster_ids[mf_faceinfo_cellsplus[v][f]/Operator::n_vect]!=actual_cluster
-                                      && is_neighbor_of_update_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect] )
-                                    ||
-                                    ( cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]!=actual_cluster
-                                      && cell_cluster_ids[mf_faceinfo_cellsplus[v][f]/Operator::n_vect]==actual_cluster
-                                      && is_neighbor_of_update_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] ) )
-                                {
-                                  evaluate_face[f] = true;
-                                  // set masks
-                                  if (cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect]==actual_cluster)
-                                    {
-                                      phi_to_dst[f][v] = true;
-                                      if (write_to_fluxmemory)
-                                        phi_neighbor_to_fluxmemory[f][v] = true;
-                                    }
-                                  else
-                                    {
-                                      if (write_to_fluxmemory)
-                                        phi_to_fluxmemory[f][v] = true;
-                                      phi_neighbor_to_dst[f][v] = true;
-                                    }
-                                }
-                            }
-                        }
-                  }
-                else // boundary faces
-                  {
-                    // no contribution from boundary faces in this stage
-                  }
-              }
             // do first ader
-            op.evaluate_cells_and_faces_first_ader(local_state,dst);
+            op.evaluate_cells_and_faces_first_ader(local_state,face_contributions);
           }
       } // check the slower cluster
 
@@ -982,57 +1837,51 @@ namespace HDG_WE
       t2 = t2sa;
 
       // setup the element list that need evaluation (all of actual_cluster)
-      for (unsigned int e=0; e<n_cells_with_ghosts; ++e)
-        {
-          if (cell_cluster_ids[e]==actual_cluster && update_cell[e])
-            evaluate_cell[e] = true;
-          else if (cell_cluster_ids[e]==actual_cluster && is_neighbor_of_update_cell[e])
-            evaluate_cell[e] = true;
-          else
-            evaluate_cell[e] = false;
-        }
+      clear_cells(evaluate_cell,evaluate_cell_list);
+      for (unsigned int i=0; i<update_cell_list.size(); ++i)
+        mark_cell(evaluate_cell,evaluate_cell_list,update_cell_list[i]);
+      for (unsigned int i=0; i<neighbor_cells.size(); ++i)
+        if (cell_cluster_ids[neighbor_cells[i]]==actual_cluster)
+          mark_cell(evaluate_cell,evaluate_cell_list,neighbor_cells[i]);
 
       // setup the face list that need evaluation (if face is in between two cells with actual cluster)
       // also, setup the masks for the write functions
-      for (unsigned int f=0; f<op.get_matrix_free().n_inner_face_batches()+op.get_matrix_free().n_boundary_face_batches(); ++f)
+      clear_faces();
+      for (unsigned int i=0; i<cluster_faces[actual_cluster].size(); ++i)
         {
-          evaluate_face[f] = false;
-          phi_to_dst[f] = std::bitset<Operator::n_vect>(false);
-          phi_neighbor_to_dst[f] = std::bitset<Operator::n_vect>(false);
-          phi_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
-          phi_neighbor_to_fluxmemory[f] = std::bitset<Operator::n_vect>(false);
+          const unsigned int f = cluster_faces[actual_cluster][i];
           // inner faces
           if (f<op.get_matrix_free().n_inner_face_batches())
             {
-              for (unsigned int v=0; v<Operator::n_vect; ++v)
-                if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int && mf_faceinfo_cellsplus[v][f]!=numbers::invalid_unsigned_int)
-                  {
-                    if ( (update_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] && update_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect])
-                         || (update_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] && evaluate_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect] && cell_cluster_ids[mf_faceinfo_cellsplus[v][f]/Operator::n_vect] == actual_cluster)
-                         || (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] && update_cell[mf_faceinfo_cellsplus[v][f]/Operator::n_vect] && cell_cluster_ids[mf_faceinfo_cellsminus[v][f]/Operator::n_vect] == actual_cluster) )
-                      {
-                        evaluate_face[f] = true;
-                        // set masks
-                        phi_to_dst[f][v] = true;
-                        phi_neighbor_to_dst[f][v] = true;
-                      }
-                  }
+              const std::bitset<n_vect> update_minus = face_flags(update_cell,face_cells_interior,f);
+              const std::bitset<n_vect> update_plus = face_flags(update_cell,face_cells_exterior,f);
+              const std::bitset<n_vect> selected = (update_minus & update_plus)
+                                                   | (update_minus & face_flags(evaluate_cell,face_cells_exterior,f)
+                                                      & face_cluster_flags(face_clusters_exterior,f,actual_cluster))
+                                                   | (update_plus & face_flags(evaluate_cell,face_cells_interior,f)
+                                                      & face_cluster_flags(face_clusters_interior,f,actual_cluster));
+              if (selected.any())
+                {
+                  mark_face(f);
+                  // set masks, only update cells consume their face
+                  // contributions
+                  phi_to_dst[f] |= selected & update_minus;
+                  phi_neighbor_to_dst[f] |= selected & update_plus;
+                }
             }
           else // boundary faces
             {
-              for (unsigned int v=0; v<Operator::n_vect; ++v)
+              const std::bitset<n_vect> update_minus = face_flags(update_cell,face_cells_interior,f);
+              if (update_minus.any())
                 {
-                  if (mf_faceinfo_cellsminus[v][f]!=numbers::invalid_unsigned_int)
-                    if (evaluate_cell[mf_faceinfo_cellsminus[v][f]/Operator::n_vect])
-                      {
-                        evaluate_face[f] = true;
-                        phi_to_dst[f][v] = true;
-                      }
+                  mark_face(f);
+                  phi_to_dst[f] |= update_minus;
                 }
             }
         }
       // do first ader
-      op.evaluate_cells_and_faces_first_ader(local_state,dst);
+      set_ghost_clusters(actual_cluster,actual_cluster);
+      op.evaluate_cells_and_faces_first_ader(local_state,face_contributions);
     }
     // sum the flux memory contribution from all processors
     {
@@ -1040,12 +1889,13 @@ namespace HDG_WE
     }
     // do the update
     {
-      // the evaluate cell vector can be reused
-      // only the time step size is needed
-      op.evaluate_cells_second_ader(local_state,dst);
+      // advances the update cells in place and resets their face
+      // contributions, such that face_contributions is zero again
+      op.evaluate_cells_second_ader(local_state,face_contributions);
     }
-    local_state -= dst;
-    dst = 0;
+
+    // reset the neighbor flags
+    clear_cells(is_neighbor_of_update_cell,neighbor_cells);
   }
 
 }
@@ -56,6 +56,8 @@ namespace HDG_WE
   // 1 - soft wall - normal velocity component is zero
   // 2 - hard wall - pressure is zero
   // 3 - absorbing wall - mimics an open domain by the first order absorbing condition
+  // boundary_id 0 mixes all three: soft walls at x=0 and x=1, a hard wall at
+  // y=0 and absorbing walls on the remaining faces
   template <int dim>
   void input_geometry_description(Triangulation<dim> &tria, const Parameters &parameters)
   {
@@ -72,7 +74,16 @@ namespace HDG_WE
         for (; cell!=endc; ++cell)
           for (unsigned f=0; f<GeometryInfo<dim>::faces_per_cell; ++f)
             if (cell->face(f)->at_boundary())
-              cell->face(f)->set_boundary_id(parameters.boundary_id);
+              {
+                if (parameters.boundary_id != 0)
+                  cell->face(f)->set_boundary_id(parameters.boundary_id);
+                else if (f < 2)
+                  cell->face(f)->set_boundary_id(1);
+                else if (f == 2)
+                  cell->face(f)->set_boundary_id(2);
+                else
+                  cell->face(f)->set_boundary_id(3);
+              }
 
         // set the materials according to your material definitions above!
         cell = tria.begin_active();
@@ -90,12 +101,14 @@ namespace HDG_WE
 
 
   // define the "exact solution" (first dim components are for velocity, last for the pressure)
-  // this function is also used for the initial conditions
-  template <int dim>
-  double input_exact_solution(const Point<dim> &p, const double t, const unsigned int component,
+  // this function is also used for the initial conditions. Number is double
+  // or a VectorizedArray, in which case all lanes are evaluated at once
+  template <int dim, typename Number>
+  Number input_exact_solution(const Point<dim,Number> &p, const double t, const unsigned int component,
                               const bool time_derivative, const int initial_cases, const int membrane_modes)
   {
-    double return_value = 0.0;
+    Number return_value;
+    return_value = 0.0;
     switch (initial_cases)
       {
       case 1:
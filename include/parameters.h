@@ -31,7 +31,9 @@ enum class IntegratorType
   ssprk,         // 6 - strong stability preserving Runge-Kutta
   ader,          // 7 - ADER time integration
   ader_lts,      // 8 - ADER with local time stepping
-  ader_adconfull // 9 - ADER relying on the global derivative operator
+  ader_adconfull, // 9 - ADER relying on the global derivative operator
+  lsrk45reg2_lts, // 10 - low storage Runge-Kutta with local time stepping
+  lsrk59reg2_lts  // 11 - low storage Runge-Kutta with local time stepping
 };
 
 class Parameters
@@ -64,6 +66,8 @@ public:
   unsigned int        adaptive_refinement_interval;
   unsigned int        n_initial_intervals;
   double              grid_transform_factor;
+  bool                mixed_precision;
+  bool                collocation_basis;
 
   // temporal discretization
   IntegratorType      integ_type;
@@ -73,6 +77,7 @@ public:
   double              output_every_time;
   bool                write_vtu_output;
   bool                cfl_stability_analysis;
+  bool                fused_inverse_mass;
 
   // initial field
   unsigned int        initial_cases;
@@ -85,6 +90,16 @@ public:
   // ader lts specific
   unsigned int        max_n_clusters;
   unsigned int        max_diff_clusters;
+  bool                optimize_clusters;
+  double              interface_overhead;
+  double              reconstruction_cost;
+
+  // parallelization
+  bool                overlap_communication;
+  unsigned int        load_balancing_interval;
+  double              load_imbalance_threshold;
+  unsigned int        n_threads;
+  bool                pin_threads;
 
   // miscellaneous
   bool                output_of_parameters;
@@ -22,6 +22,38 @@
 
 DEAL_II_NAMESPACE_OPEN
 
+// Vector update of one low-storage Runge-Kutta stage with derivative k,
+//   vector1 = base + factor1 * k,   vector2 = vector1 + factor2 * k,
+// where the second update is skipped on the last stage. Handed to the
+// operator so that it can be applied on each cell as soon as k is known.
+template <typename VectorType>
+struct LowStorageRKStageUpdate
+{
+  typedef typename VectorType::value_type Number;
+
+  LowStorageRKStageUpdate(const Number      factor1,
+                          const Number      factor2,
+                          const bool        is_last,
+                          const VectorType &base,
+                          VectorType       &vector1,
+                          VectorType       &vector2)
+    :
+    factor1 (factor1),
+    factor2 (factor2),
+    is_last (is_last),
+    base (base),
+    vector1 (vector1),
+    vector2 (vector2)
+  {}
+
+  const Number      factor1;
+  const Number      factor2;
+  const bool        is_last;
+  const VectorType &base;
+  VectorType       &vector1;
+  VectorType       &vector2;
+};
+
 // Base class for all time integrators
 template <typename VectorType, typename Operator>
 class ExplicitIntegrator
@@ -139,6 +171,25 @@ private:
 
 
 
+// Low-storage Runge-Kutta schemes of the two-register form with multirate
+// local time stepping, the operator subcycles the faster clusters
+template <typename VectorType, typename Operator>
+class LowStorageRKLTS : public ExplicitIntegrator<VectorType,Operator>
+{
+public:
+  LowStorageRKLTS (const unsigned int stages);
+
+  virtual void perform_time_step(VectorType &vec_n,
+                                 VectorType &vec_np,
+                                 const double             time_step,
+                                 Operator                &op);
+
+private:
+  std::vector<double> stage_factors, weights;
+};
+
+
+
 template <typename VectorType, typename Operator>
 class LowStorageRK45Reg3 : public ExplicitIntegrator<VectorType,Operator>
 {
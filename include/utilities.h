@@ -19,6 +19,7 @@
 #include <deal.II/fe/mapping.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/base/function.h>
+#include <deal.II/base/vectorization.h>
 
 namespace HDG_WE
 {
@@ -93,6 +94,11 @@ namespace HDG_WE
     virtual double value (const Point<dim>   &p ,
                           const unsigned int  c=0) const;
 
+    // value on all lanes of a batch of points at once
+    template <typename Number>
+    VectorizedArray<Number> value (const Point<dim,VectorizedArray<Number> > &p,
+                                   const unsigned int                         c=0) const;
+
   private:
     const int component;
     const int initial_cases;
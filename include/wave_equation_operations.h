@@ -16,15 +16,19 @@
 #ifndef wave_equation_operations_h_
 #define wave_equation_operations_h_
 
-//#define GAUSS_POINTS_VECTOR_OPERATION
-
+#include <deal.II/base/thread_local_storage.h>
 #include <deal.II/matrix_free/matrix_free.h>
 #include <deal.II/matrix_free/operators.h>
+
+#include <atomic>
+#include <memory>
+
 #include "cluster_manager.h"
 #include "cluster_manager.templates.h"
 #include "elementwise_cg.h"
 #include "elementwise_cg.templates.h"
 #include "parameters.h"
+#include "time_integrators.h"
 #include "utilities.h"
 
 namespace HDG_WE
@@ -34,6 +38,7 @@ namespace HDG_WE
   template<int, int> class WaveEquationOperationADER;
   template<int, int> class WaveEquationOperationADERLTS;
   template<int, int> class WaveEquationOperationADERADCONFULL;
+  template<int, int> class WaveEquationOperationRKLTS;
 
   // Collect all data for the inverse mass matrix operation in a struct in
   // order to avoid allocating the memory repeatedly
@@ -46,18 +51,52 @@ namespace HDG_WE
     // must point to the object 'phi'
     InverseMassMatrixData(const InverseMassMatrixData &other);
 
+    // Apply the inverse mass matrix on the cell phi[0] is set to, using the
+    // inverse JxW values stored in coefficients. For a basis collocated at
+    // the Gauss points this is a pointwise scaling.
+    void apply(const VectorizedArray<Number> *in_array,
+               VectorizedArray<Number>       *out_array) const;
+
+    // Same as submit_value(), integrate() and apply() on values given at the
+    // quadrature points, which is a copy for a collocated basis.
+    void transform_from_q_points_to_basis(const VectorizedArray<Number> *in_array,
+                                          VectorizedArray<Number>       *out_array) const;
+
     // For memory alignment reasons, need to place the FEEvaluation object
-    // into an aligned vector
+    // into an aligned vector. The second entry is scratch space for vector
+    // updates following the inverse mass matrix.
     AlignedVector<FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,Number> > phi;
     AlignedVector<VectorizedArray<Number> > coefficients;
     MatrixFreeOperators::CellwiseInverseMassMatrix<dim,fe_degree,dim+1,Number> inverse;
+    bool collocation;
+  };
+
+  // Timings of a matrix-free loop that reads ghost data. Sampled loops run
+  // the exchange and the computation one after the other, the others
+  // overlap them, which gives an estimate of the hidden latency.
+  struct CommunicationStatistics
+  {
+    CommunicationStatistics()
+      :
+      exchange_time(0.),
+      compute_time(0.),
+      overlap_time(0.),
+      n_samples(0),
+      n_overlapped(0)
+    {}
+
+    double       exchange_time;
+    double       compute_time;
+    double       overlap_time;
+    unsigned int n_samples;
+    unsigned int n_overlapped;
   };
 
-  template<int dim>
+  template<int dim, typename Number = double>
   class WaveEquationOperationBase
   {
   public:
-    typedef double value_type;
+    typedef Number value_type;
     virtual void setup(const MappingQGeneric<dim>                 &mapping,
                        const std::vector<const DoFHandler<dim> *> &dof_handlers,
                        const std::vector<Material>                &mats,
@@ -68,6 +107,33 @@ namespace HDG_WE
     // allow access to matrix free object
     virtual const MatrixFree<dim,value_type> &get_matrix_free() const = 0;
 
+    // Initialize a vector for the DoFHandler with index dof_index directly
+    // from the partitioner of the MatrixFree object, without an intermediate
+    // vector of the same size. The reinit with a partitioner cannot skip the
+    // zeroing and touches the pages first, in index chunks that TBB hands to
+    // whichever worker is free. This decides the page placement, the zeroing
+    // in the cell loop afterwards does not move pages. The NUMA placement of
+    // the vectors is therefore not controlled, report_page_distribution()
+    // in explicit_wave.cc only shows the outcome.
+    void initialize_dof_vector(LinearAlgebra::distributed::Vector<value_type> &vec,
+                               const unsigned int                              dof_index = 0) const
+    {
+      // release the old memory, a reinit of the same size would keep its pages
+      LinearAlgebra::distributed::Vector<value_type>().swap(vec);
+      vec.reinit(get_matrix_free().get_vector_partitioner(dof_index));
+
+      const std::function<void (const MatrixFree<dim,value_type> &,
+                                LinearAlgebra::distributed::Vector<value_type> &,
+                                const unsigned int &,
+                                const std::pair<unsigned int,unsigned int> &)>
+      zero_only = [] (const MatrixFree<dim,value_type> &,
+                      LinearAlgebra::distributed::Vector<value_type> &,
+                      const unsigned int &,
+                      const std::pair<unsigned int,unsigned int> &) {};
+      const unsigned int dummy = 0;
+      get_matrix_free().cell_loop(zero_only, vec, dummy, true);
+    }
+
     // allow access to time control
     virtual TimeControl &get_time_control() const = 0;
 
@@ -75,10 +141,32 @@ namespace HDG_WE
     virtual void apply (const LinearAlgebra::distributed::Vector<value_type> &src,
                         LinearAlgebra::distributed::Vector<value_type>       &dst) const = 0;
 
+    // Evaluation followed by the update of a low-storage Runge-Kutta stage.
+    // Returns false if the operator cannot fuse the update, in which case
+    // dst holds the result of apply().
+    virtual bool apply_and_update (const LinearAlgebra::distributed::Vector<value_type>                                  &src,
+                                   LinearAlgebra::distributed::Vector<value_type>                                        &dst,
+                                   const LowStorageRKStageUpdate<LinearAlgebra::distributed::Vector<value_type> > &) const
+    {
+      apply(src, dst);
+      return false;
+    }
+
     // Standard evaluation routine
     virtual void apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
                              LinearAlgebra::distributed::Vector<value_type> &) const = 0;
 
+    // Advance the state in place by one global time step of a low-storage
+    // Runge-Kutta scheme with local time steps, given the factors a_{i+1,i}
+    // and the weights b_i of its two-register form (only interesting for
+    // multirate Runge-Kutta)
+    virtual void apply_multirate_rk (const std::vector<double> &,
+                                     const std::vector<double> &,
+                                     LinearAlgebra::distributed::Vector<value_type> &) const
+    {
+      AssertThrow(false, ExcNotImplemented());
+    }
+
     // projection of initial field
     virtual void project_initial_field(LinearAlgebra::distributed::Vector<value_type> &solution,
                                        const Function<dim>                                     &function) const = 0;
@@ -95,17 +183,24 @@ namespace HDG_WE
     virtual unsigned int cluster_id(unsigned int ) const = 0;
     virtual value_type time_step(unsigned int ) const = 0;
 
+    // relative load imbalance between the ranks, used to trigger a
+    // repartitioning (only interesting for ADER LTS)
+    virtual double load_imbalance() const
+    {
+      return 0.;
+    }
+
   };
 
 
 
   // Definition of the class WaveEquationOperation containing all evaluation
   // routines and some basic informations like time and material properties
-  template<int dim, int fe_degree>
-  class WaveEquationOperation : public WaveEquationOperationBase<dim>
+  template<int dim, int fe_degree, typename Number = double>
+  class WaveEquationOperation : public WaveEquationOperationBase<dim,Number>
   {
   public:
-    typedef typename WaveEquationOperationBase<dim>::value_type value_type;
+    typedef typename WaveEquationOperationBase<dim,Number>::value_type value_type;
     static const int dimension = dim;
 
     // Constructor
@@ -135,6 +230,12 @@ namespace HDG_WE
     void apply (const LinearAlgebra::distributed::Vector<value_type> &src,
                 LinearAlgebra::distributed::Vector<value_type>       &dst) const;
 
+    // Evaluation with the Runge-Kutta stage update applied on each cell
+    // right after the inverse mass matrix
+    bool apply_and_update (const LinearAlgebra::distributed::Vector<value_type>                                  &src,
+                           LinearAlgebra::distributed::Vector<value_type>                                        &dst,
+                           const LowStorageRKStageUpdate<LinearAlgebra::distributed::Vector<value_type> > &update) const;
+
     // Standard evaluation routine
     virtual void apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
                              LinearAlgebra::distributed::Vector<value_type> &) const;
@@ -172,18 +273,57 @@ namespace HDG_WE
     // Vectors with material properties for elements
     AlignedVector<VectorizedArray<value_type> > densities, speeds;
 
+    // Material properties of the neighbor behind each face of a cell batch,
+    // needed for the cell-centric face evaluation
+    AlignedVector<VectorizedArray<value_type> > face_densities, face_speeds;
+
+    // apply() runs faces cell by cell and fuses the inverse mass matrix
+    // (only on conforming meshes)
+    bool                                    use_fused_apply;
+
     // Mass matrix data
-    //mutable std_cxx11::shared_ptr<InverseMassMatrixData<dim,fe_degree,value_type> > mass_matrix_data;
-    mutable std::shared_ptr<InverseMassMatrixData<dim,fe_degree,value_type> > mass_matrix_data;
+    // one copy per thread, such that cell loops may run on several threads
+    mutable std::shared_ptr<Threads::ThreadLocalStorage<InverseMassMatrixData<dim,fe_degree,value_type> > > mass_matrix_data;
+
+    // cell batches per task when cell loops outside of MatrixFree::loop run
+    // on the thread pool
+    static const unsigned int cell_grain_size = 8;
+
+    // Runge-Kutta stage update pending during apply_and_update()
+    mutable const LowStorageRKStageUpdate<LinearAlgebra::distributed::Vector<value_type> > *stage_update;
 
     // Vector to store computing times for different actions
     mutable std::vector<double>                    computing_times;
 
+    // Ghost exchange statistics of the loops in apply (0) and the ADER
+    // corrector (1). The LTS face evaluations exchange through the
+    // ClusterManager without overlap and are not sampled
+    mutable std::vector<CommunicationStatistics>   communication_statistics;
+
+    // Run a loop reading the ghosts of src and record its timings in
+    // communication_statistics[index]
+    template <typename LoopType>
+    void timed_loop(const LoopType                                       &loop,
+                    const LinearAlgebra::distributed::Vector<value_type> &src,
+                    const unsigned int                                    index) const;
+
+    // Projection onto the DG space in a threaded cell loop, evaluate returns
+    // the values of all components at a batch of quadrature points
+    template <typename FunctorType>
+    void project_function(LinearAlgebra::distributed::Vector<value_type> &solution,
+                          const FunctorType                              &evaluate) const;
+
     void local_apply_mass_matrix(const MatrixFree<dim,value_type>                     &data,
                                  LinearAlgebra::distributed::Vector<value_type>       &dst,
                                  const LinearAlgebra::distributed::Vector<value_type> &src,
                                  const std::pair<unsigned int,unsigned int>           &cell_range) const;
 
+    // Write the cell result held by phi to dst, or apply the pending stage
+    // update to it
+    void write_cell_result(FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                           const unsigned int                                        cell,
+                           LinearAlgebra::distributed::Vector<value_type>           &dst) const;
+
     void local_apply_domain (const MatrixFree<dim,value_type>                     &data,
                              LinearAlgebra::distributed::Vector<value_type>       &dst,
                              const LinearAlgebra::distributed::Vector<value_type> &src,
@@ -217,12 +357,93 @@ namespace HDG_WE
                                 const value_type                                              boundary_fac,
                                 LinearAlgebra::distributed::Vector<value_type>               *dst) const;
 
+    // Cell integral, all face integrals seen from the cell and the inverse
+    // mass matrix in one sweep
+    void local_apply_fused (const MatrixFree<dim,value_type>                     &data,
+                            LinearAlgebra::distributed::Vector<value_type>       &dst,
+                            const LinearAlgebra::distributed::Vector<value_type> &src,
+                            const std::pair<unsigned int,unsigned int>           &cell_range) const;
+
+    void evaluate_face_by_cell(FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                               FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor,
+                               const LinearAlgebra::distributed::Vector<value_type>         &src,
+                               const unsigned int                                            cell,
+                               const unsigned int                                            face) const;
+
+    // Cell integral and all face integrals seen from the cell, summed into
+    // the local vector of phi
+    void evaluate_cell_and_faces(FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type>       &velocity,
+                                 FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type>         &pressure,
+                                 FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_face,
+                                 FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor,
+                                 FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>     &phi,
+                                 const LinearAlgebra::distributed::Vector<value_type>         &src,
+                                 const unsigned int                                            cell) const;
+
 
     // need this for local_apply_mass_matrix
     template <int, int> friend class WaveEquationOperationADER;
     template <int, int> friend class WaveEquationOperationADERADCONFULL;
   };
 
+
+
+  // Mixed precision: the spatial operator is evaluated in single precision
+  // while the time integrator works on double precision state vectors
+  template<int dim, int fe_degree>
+  class WaveEquationOperationMixed : public WaveEquationOperationBase<dim>
+  {
+  public:
+    typedef typename WaveEquationOperationBase<dim>::value_type value_type;
+    typedef float                                               number_type;
+
+    WaveEquationOperationMixed(TimeControl &time_control_in, Parameters &parameters_in);
+
+    virtual void setup(const MappingQGeneric<dim>                 &mapping,
+                       const std::vector<const DoFHandler<dim> *> &dof_handlers,
+                       const std::vector<Material>                &mats,
+                       const std::vector<unsigned int>            &vectorization_categories = std::vector<unsigned int>());
+
+    virtual std::string Name();
+
+    // matrix free object in double precision, only holds the DoF layout for
+    // the state vectors
+    const MatrixFree<dim,value_type> &get_matrix_free() const;
+
+    TimeControl &get_time_control() const;
+
+    void apply (const LinearAlgebra::distributed::Vector<value_type> &src,
+                LinearAlgebra::distributed::Vector<value_type>       &dst) const;
+
+    void apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
+                     LinearAlgebra::distributed::Vector<value_type> &) const;
+
+    void project_initial_field(LinearAlgebra::distributed::Vector<value_type> &solution,
+                               const Function<dim>                            &function) const;
+
+    void compute_post_pressure(const LinearAlgebra::distributed::Vector<value_type> &solution,
+                               LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
+                               LinearAlgebra::distributed::Vector<value_type>       &post_pressure) const;
+
+    void estimate_error(const LinearAlgebra::distributed::Vector<value_type> &solution,
+                        LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
+                        Vector<double>                                       &error_estimate) const;
+
+    unsigned int cluster_id(unsigned int ) const;
+
+    value_type time_step(unsigned int ) const;
+
+  private:
+    // single precision operator
+    WaveEquationOperation<dim,fe_degree,number_type> operation;
+
+    MatrixFree<dim,value_type>              data;
+
+    // single precision copies of input and output of the operator
+    mutable LinearAlgebra::distributed::Vector<number_type> src_number, dst_number;
+    mutable LinearAlgebra::distributed::Vector<number_type> post_number;
+  };
+
   template<int dim, int fe_degree>
   class WaveEquationOperationADER : public WaveEquationOperation<dim,fe_degree>
   {
@@ -245,7 +466,10 @@ namespace HDG_WE
                              LinearAlgebra::distributed::Vector<value_type>       &dst) const;
 
   protected:
-    // additional vector to work with (stores temporal values between first and second evaluation)
+    // additional vector to work with (stores temporal values between first and second evaluation).
+    // The predicted values of a cell batch are read by the correctors of its
+    // neighbors, which may run on other threads, and by other ranks through
+    // the ghost exchange, so they are kept in a full vector
     mutable LinearAlgebra::distributed::Vector<value_type> tempsrc;
 
     // temporary data structures for particular evaluation within
@@ -290,6 +514,23 @@ namespace HDG_WE
                                                  LinearAlgebra::distributed::Vector<value_type>       &dst,
                                                  const LinearAlgebra::distributed::Vector<value_type> &src,
                                                  const std::pair<unsigned int,unsigned int>           &cell_range) const;
+
+    // Predictor and corrector without barriers between the phases: each cell
+    // batch is corrected, including the inverse mass matrix, as soon as the
+    // predictors of its face neighbors are done (only on conforming meshes)
+    void apply_ader_task_graph (const LinearAlgebra::distributed::Vector<value_type> &src,
+                                LinearAlgebra::distributed::Vector<value_type>       &dst) const;
+
+    // for each cell batch the batches whose corrector reads its predictor,
+    // and the number of predictors plus ghost exchange its corrector waits for
+    std::vector<std::vector<unsigned int> >              dependent_batches;
+    std::vector<unsigned int>                            n_dependencies;
+    mutable std::unique_ptr<std::atomic<unsigned int>[]> pending_dependencies;
+
+    // cell batches with a ghost neighbor, and the order of the predictors
+    // starting with these batches
+    std::vector<unsigned int>                            ghost_neighbor_batches;
+    std::vector<unsigned int>                            batch_order;
   };
 
 
@@ -314,8 +555,24 @@ namespace HDG_WE
                              LinearAlgebra::distributed::Vector<value_type>       &dst) const;
 
   protected:
-    // additional vector to work with (stores temporal values between first and second evaluation)
+    // additional vector to work with (stores the unscaled residual of each
+    // derivative evaluation)
     mutable LinearAlgebra::distributed::Vector<value_type> tempsrc;
+
+    // negative of the last derivative, the source of the next evaluation
+    mutable LinearAlgebra::distributed::Vector<value_type> tempvals;
+
+    // factor of the current term of the Taylor series, and whether it is
+    // the first one which initializes the sum
+    mutable value_type taylor_factor;
+    mutable bool       first_taylor_term;
+
+    // Inverse mass matrix on the residual in src followed by the Taylor
+    // series update dst -= taylor_factor * k and tempvals = -k
+    void local_apply_mass_matrix_taylor(const MatrixFree<dim,value_type>                     &data,
+                                        LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                        const LinearAlgebra::distributed::Vector<value_type> &src,
+                                        const std::pair<unsigned int,unsigned int>           &cell_range) const;
   };
 
 
@@ -337,7 +594,7 @@ namespace HDG_WE
 
     virtual std::string Name();
 
-    // Overwrite base evaluation routine
+    // Overwrite base evaluation routine, src and dst may be the same vector
     virtual void apply_ader (const LinearAlgebra::distributed::Vector<value_type> &src,
                              LinearAlgebra::distributed::Vector<value_type>       &dst) const;
 
@@ -345,6 +602,8 @@ namespace HDG_WE
 
     virtual value_type time_step(unsigned int cell) const;
 
+    virtual double load_imbalance() const;
+
     void communicate_flux_memory() const;
 
   private:
@@ -355,8 +614,12 @@ namespace HDG_WE
     // current time
     mutable double time;
 
-    // flux memory vector
-    mutable LinearAlgebra::distributed::Vector<value_type> flux_memory;
+    // flux memory of the cell batches at cluster interfaces, dofs_per_cell
+    // entries per batch in the order of the cluster manager's flux memory index
+    mutable AlignedVector<VectorizedArray<value_type> > flux_memory;
+
+    // cell batches of tempsrc written by the last first ader step
+    mutable std::vector<unsigned int> tempsrc_cells;
 
     // we need this frequently for index calculations
     static const unsigned int n_vect = VectorizedArray<value_type>::n_array_elements;
@@ -364,23 +627,47 @@ namespace HDG_WE
     void evaluate_cells_and_faces_first_ader(const LinearAlgebra::distributed::Vector<value_type>  &src,
                                              LinearAlgebra::distributed::Vector<value_type>        &dst) const;
 
-    void evaluate_cells_second_ader(const LinearAlgebra::distributed::Vector<value_type>  &src,
-                                    LinearAlgebra::distributed::Vector<value_type>        &dst) const;
+    // advance the state of the update cells in place and reset their face
+    // contributions
+    void evaluate_cells_second_ader(LinearAlgebra::distributed::Vector<value_type>  &state,
+                                    LinearAlgebra::distributed::Vector<value_type>  &face_contributions) const;
+
+    // save and restore the values of some cells, used to undo the
+    // temporary updates of the reconstruction
+    void copy_cells_to_buffer(const std::vector<unsigned int>                      &cells,
+                              const LinearAlgebra::distributed::Vector<value_type> &src,
+                              AlignedVector<VectorizedArray<value_type> >          &buffer) const;
+
+    void copy_buffer_to_cells(const std::vector<unsigned int>                      &cells,
+                              const AlignedVector<VectorizedArray<value_type> >    &buffer,
+                              LinearAlgebra::distributed::Vector<value_type>       &dst) const;
+
+    typedef void (WaveEquationOperationADERLTS::*face_worker)(const MatrixFree<dim,value_type> &,
+                                                              LinearAlgebra::distributed::Vector<value_type> &,
+                                                              const LinearAlgebra::distributed::Vector<value_type> &,
+                                                              const std::pair<unsigned int,unsigned int> &) const;
+
+    // run the face workers on the face ranges of the cluster currently
+    // evaluated by the cluster manager, including the ghost exchange
+    void face_range_loop(const face_worker                                     inner_face_worker,
+                         const face_worker                                     boundary_face_worker,
+                         LinearAlgebra::distributed::Vector<value_type>       &dst,
+                         const LinearAlgebra::distributed::Vector<value_type> &src) const;
 
     virtual void local_apply_firstader_domain (const MatrixFree<dim,value_type>                              &data,
                                                LinearAlgebra::distributed::Vector<value_type>        &dst,
                                                const LinearAlgebra::distributed::Vector<value_type>  &src,
                                                const std::pair<unsigned int,unsigned int>                &cell_range) const;
 
-    virtual void local_apply_secondader_domain (const MatrixFree<dim,value_type>                              &data,
-                                                LinearAlgebra::distributed::Vector<value_type>        &dst,
-                                                const LinearAlgebra::distributed::Vector<value_type>  &src,
-                                                const std::pair<unsigned int,unsigned int>                &cell_range) const;
+    // add the integrated face contribution of one lane of phi to the flux
+    // memory of the given cell (index of the cell batch times n_vect plus lane)
+    void add_to_flux_memory(const FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                            const unsigned int                                                  lane,
+                            const unsigned int                                                  cell) const;
 
-    void local_apply_dummy_domain (const MatrixFree<dim,value_type>                              &data,
-                                   LinearAlgebra::distributed::Vector<value_type>        &dst,
-                                   const LinearAlgebra::distributed::Vector<value_type>  &src,
-                                   const std::pair<unsigned int,unsigned int>                &cell_range) const;
+    void local_apply_secondader_update (LinearAlgebra::distributed::Vector<value_type>  &state,
+                                        LinearAlgebra::distributed::Vector<value_type>  &face_contributions,
+                                        const std::pair<unsigned int,unsigned int>      &cell_range) const;
 
     // overwrite face routines
     virtual void local_apply_ader_face (const MatrixFree<dim,value_type>       &data,
@@ -419,6 +706,102 @@ namespace HDG_WE
 
   };
 
+
+
+  // Runge-Kutta evaluation with local time steps: the cluster manager
+  // advances its clusters by a multirate low-storage Runge-Kutta scheme and
+  // calls the evaluation on the cells of one cluster at a time
+  template<int dim, int fe_degree>
+  class WaveEquationOperationRKLTS : public WaveEquationOperation<dim,fe_degree>
+  {
+    template <typename> friend class ClusterManager;
+
+  public:
+    typedef typename WaveEquationOperation<dim,fe_degree>::value_type value_type;
+
+    WaveEquationOperationRKLTS(TimeControl &time_control_in, Parameters &parameters_in);
+
+    virtual void setup(const MappingQGeneric<dim>                 &mapping,
+                       const std::vector<const DoFHandler<dim> *> &dof_handlers,
+                       const std::vector<Material>                &mats,
+                       const std::vector<unsigned int>            &vectorization_categories = std::vector<unsigned int>());
+
+    virtual std::string Name();
+
+    virtual void apply_multirate_rk (const std::vector<double>                      &stage_factors,
+                                     const std::vector<double>                      &weights,
+                                     LinearAlgebra::distributed::Vector<value_type> &state) const;
+
+    unsigned int cluster_id(unsigned int cell) const;
+
+    virtual value_type time_step(unsigned int cell) const;
+
+    virtual double load_imbalance() const;
+
+  private:
+
+    // cluster manager
+    ClusterManager<value_type> cluster_manager;
+
+    // we need this frequently for index calculations
+    static const unsigned int n_vect = VectorizedArray<value_type>::n_array_elements;
+
+    // derivative of the state on the cells flagged by the cluster manager,
+    // the other cells of dst are left untouched
+    void evaluate_selected_cells(const LinearAlgebra::distributed::Vector<value_type> &src,
+                                 LinearAlgebra::distributed::Vector<value_type>       &dst) const;
+
+    // stage update of the two-register scheme on some cells with the
+    // derivative k: state = base + stage_factor * k and accumulator = base +
+    // weight * k, or state = base + weight * k on the last stage. The base is
+    // the state on the first stage and the accumulator otherwise.
+    void update_stage(const std::vector<unsigned int>                      &cells,
+                      const LinearAlgebra::distributed::Vector<value_type> &derivative,
+                      const value_type                                      stage_factor,
+                      const value_type                                      weight,
+                      const bool                                            is_first,
+                      const bool                                            is_last,
+                      LinearAlgebra::distributed::Vector<value_type>       &state,
+                      LinearAlgebra::distributed::Vector<value_type>       &accumulator) const;
+
+    // save and restore the values of some cells, and set them to a linear
+    // combination of two saved states
+    void copy_cells_to_buffer(const std::vector<unsigned int>                      &cells,
+                              const LinearAlgebra::distributed::Vector<value_type> &src,
+                              AlignedVector<VectorizedArray<value_type> >          &buffer) const;
+
+    void copy_buffer_to_cells(const std::vector<unsigned int>                      &cells,
+                              const AlignedVector<VectorizedArray<value_type> >    &buffer,
+                              LinearAlgebra::distributed::Vector<value_type>       &dst) const;
+
+    void combine_buffers_to_cells(const std::vector<unsigned int>                   &cells,
+                                  const AlignedVector<VectorizedArray<value_type> > &buffer0,
+                                  const value_type                                   factor0,
+                                  const AlignedVector<VectorizedArray<value_type> > &buffer1,
+                                  const value_type                                   factor1,
+                                  LinearAlgebra::distributed::Vector<value_type>    &dst) const;
+
+    void local_apply_lts_domain (const MatrixFree<dim,value_type>                     &data,
+                                 LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                 const LinearAlgebra::distributed::Vector<value_type> &src,
+                                 const std::pair<unsigned int,unsigned int>           &cell_range) const;
+
+    void local_apply_lts_face (const MatrixFree<dim,value_type>                     &data,
+                               LinearAlgebra::distributed::Vector<value_type>       &dst,
+                               const LinearAlgebra::distributed::Vector<value_type> &src,
+                               const std::pair<unsigned int,unsigned int>           &face_range) const;
+
+    void local_apply_lts_boundary_face (const MatrixFree<dim,value_type>                     &data,
+                                        LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                        const LinearAlgebra::distributed::Vector<value_type> &src,
+                                        const std::pair<unsigned int,unsigned int>           &face_range) const;
+
+    void local_apply_lts_mass_matrix (const MatrixFree<dim,value_type>                     &data,
+                                      LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                      const LinearAlgebra::distributed::Vector<value_type> &src,
+                                      const std::pair<unsigned int,unsigned int>           &cell_range) const;
+  };
+
 }
 
 #endif /* wave_equation_operations_h_ */
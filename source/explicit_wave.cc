@@ -16,6 +16,7 @@
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/function.h>
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/multithread_info.h>
 #include <deal.II/base/thread_local_storage.h>
 #include <deal.II/base/timer.h>
 #include <deal.II/base/revision.h>
@@ -51,6 +52,17 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef DEAL_II_WITH_THREADS
+#include <tbb/task_scheduler_observer.h>
+#endif
+#endif
 
 #include "../include/input_parameters.h"
 #include "../include/parameters.h"
@@ -106,6 +118,21 @@ namespace HDG_WE
 
 
 
+  // Scalar DG element for each solution component. The collocated variant
+  // puts the nodes on the Gauss points used by MatrixFree, which turns the
+  // interpolation to quadrature points into the identity and the mass
+  // matrix into a diagonal.
+  template <int dim>
+  std::unique_ptr<FiniteElement<dim> > create_dg_element(const Parameters &parameters)
+  {
+    if (parameters.collocation_basis)
+      return std::unique_ptr<FiniteElement<dim> >(new FE_DGQArbitraryNodes<dim>(QGauss<1>(parameters.fe_degree+1)));
+    else
+      return std::unique_ptr<FiniteElement<dim> >(new FE_DGQ<dim>(parameters.fe_degree));
+  }
+
+
+
   // Class WaveEquationProblem as  base class for this setup. It holds all
   // necessary informations like triangulation, dof handler, ...
   template<int dim>
@@ -127,6 +154,8 @@ namespace HDG_WE
 
     void adapt_mesh();
 
+    void rebalance_mesh();
+
     LinearAlgebra::distributed::Vector<value_type> solutions, tmp_solutions;
     LinearAlgebra::distributed::Vector<value_type> post_pressure;
 
@@ -136,7 +165,7 @@ namespace HDG_WE
 
     Parameters                    &parameters;
     MyTriangulation<dim>           triangulation;
-    MappingQGeneric<dim>           mapping;
+    std::shared_ptr<MappingQGeneric<dim> > mapping;
     FESystem<dim>                  fe;
     FE_DGQArbitraryNodes<dim>      fe_spectral, fe_post_disp;
     DoFHandler<dim>                dof_handler, dof_handler_spectral, dof_handler_post_disp;
@@ -158,9 +187,7 @@ namespace HDG_WE
     pcout (std::cout,Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)==0),
     parameters(parameters_in),
     triangulation(MPI_COMM_WORLD),
-    mapping(parameters.fe_degree),
-    fe(FE_DGQ<dim>(parameters.fe_degree), dim+1),
-    //fe(FE_DGQArbitraryNodes<dim>(QGauss<1>(fe_degree+1)),dim+1),
+    fe(*create_dg_element<dim>(parameters), dim+1),
     fe_spectral(QGauss<1>(parameters.fe_degree+1)),
     fe_post_disp(QGaussLobatto<1>(parameters.fe_degree+2)),
     dof_handler(triangulation),
@@ -179,6 +206,16 @@ namespace HDG_WE
   {
     input_geometry_description(triangulation,parameters);
 
+    // straight-sided cells are described exactly by a linear mapping, which
+    // keeps the geometry setup cheap and lets MatrixFree classify all
+    // parallelogram cells as affine
+    const std::vector<types::manifold_id> manifold_ids = triangulation.get_manifold_ids();
+    bool flat_geometry = true;
+    for (unsigned int i=0; i<manifold_ids.size(); ++i)
+      if (manifold_ids[i] != numbers::flat_manifold_id)
+        flat_geometry = false;
+    mapping.reset(new MappingQGeneric<dim>(flat_geometry ? 1 : parameters.fe_degree));
+
     pcout << "Number of global active cells: "
           << triangulation.n_global_active_cells()
           << std::endl;
@@ -196,6 +233,62 @@ namespace HDG_WE
 
 
 
+  // Print on which NUMA nodes the pages of the locally owned part of a vector
+  // reside, one line per rank. This is a diagnostic only: the placement
+  // follows the first touch in the vector reinit, which is not tied to the
+  // cells a thread evaluates later, see initialize_dof_vector()
+  void report_page_distribution(const LinearAlgebra::distributed::Vector<double> &vec)
+  {
+    std::ostringstream report;
+    report << "   Rank " << std::setw(4) << Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) << ":";
+#if defined(__linux__) && defined(SYS_move_pages)
+    const std::uintptr_t page_size = sysconf(_SC_PAGESIZE);
+    const std::uintptr_t begin = reinterpret_cast<std::uintptr_t>(vec.begin());
+    const std::uintptr_t end = reinterpret_cast<std::uintptr_t>(vec.begin()+vec.local_size());
+    std::vector<void *> pages;
+    for (std::uintptr_t p=begin/page_size*page_size; p<end; p+=page_size)
+      pages.push_back(reinterpret_cast<void *>(p));
+
+    // without target nodes, move_pages only queries the node of each page
+    std::vector<int> status(pages.size(), -1);
+    std::vector<unsigned int> pages_on_node;
+    unsigned int n_unresolved = 0;
+    if (!pages.empty() &&
+        syscall(SYS_move_pages, 0, pages.size(), pages.data(), nullptr, status.data(), 0) == 0)
+      {
+        for (unsigned int i=0; i<status.size(); ++i)
+          if (status[i] >= 0)
+            {
+              if (static_cast<unsigned int>(status[i]) >= pages_on_node.size())
+                pages_on_node.resize(status[i]+1, 0);
+              ++pages_on_node[status[i]];
+            }
+          else
+            ++n_unresolved;
+      }
+    else
+      n_unresolved = pages.size();
+
+    for (unsigned int n=0; n<pages_on_node.size(); ++n)
+      report << " node " << n << ": " << pages_on_node[n] << " pages";
+    if (n_unresolved > 0)
+      report << " unresolved: " << n_unresolved << " pages";
+#else
+    (void)vec;
+    report << " not available";
+#endif
+
+    const std::vector<std::string> reports = Utilities::MPI::gather(MPI_COMM_WORLD, report.str());
+    if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0)
+      {
+        std::cout << "   Page distribution of the solution vector (first touch, not controlled):" << std::endl;
+        for (unsigned int p=0; p<reports.size(); ++p)
+          std::cout << reports[p] << std::endl;
+      }
+  }
+
+
+
   template<int dim>
   void WaveEquationProblem<dim>::make_dofs()
   {
@@ -220,12 +313,13 @@ namespace HDG_WE
     dof_handlers[1] = &dof_handler_post_disp;
 
     time_control.set_time_step(compute_time_step_size(triangulation,parameters));
-    wave_equation_op->setup(mapping,dof_handlers,input_materials());
+    wave_equation_op->setup(*mapping,dof_handlers,input_materials());
 
     time.restart();
-    wave_equation_op->get_matrix_free().initialize_dof_vector(solutions);
-    tmp_solutions.reinit(solutions);
-    wave_equation_op->get_matrix_free().initialize_dof_vector(post_pressure, 1);
+    wave_equation_op->initialize_dof_vector(solutions);
+    wave_equation_op->initialize_dof_vector(tmp_solutions);
+    wave_equation_op->initialize_dof_vector(post_pressure, 1);
+    report_page_distribution(solutions);
 
     {
       Utilities::System::MemoryStats stats;
@@ -322,15 +416,37 @@ namespace HDG_WE
     sol_trans.interpolate(xsol, solutions);
 #endif
 
-    // ader_lts sets the time step size in its setup routine (called in make_dofs)
+    // the lts integrators set the time step size in their setup routine (called in make_dofs)
     // the other integrators do not update the time themselves and have to get it from
     // the compute_time_step_size routine
-    if (parameters.integ_type!=IntegratorType::ader_lts)
+    if (parameters.integ_type!=IntegratorType::ader_lts &&
+        parameters.integ_type!=IntegratorType::lsrk45reg2_lts &&
+        parameters.integ_type!=IntegratorType::lsrk59reg2_lts)
       time_control.set_time_step(compute_time_step_size(triangulation,parameters));
   }
 
 
 
+  template <int dim>
+  void
+  WaveEquationProblem<dim>::rebalance_mesh()
+  {
+#ifdef DEAL_II_WITH_P4EST
+    AssertThrow(dim > 1, ExcNotImplemented());
+
+    // the cell weights connected by the cluster manager now contain the
+    // measured costs, repartition with them and carry the solution along
+    parallel::distributed::SolutionTransfer<(dim>1?dim:2),LinearAlgebra::distributed::Vector<value_type> >
+    sol_trans(*reinterpret_cast<const DoFHandler<(dim>1?dim:2)>*>(&dof_handler));
+    sol_trans.prepare_for_coarsening_and_refinement(solutions);
+    triangulation.repartition();
+    make_dofs ();
+    sol_trans.interpolate(solutions);
+#endif
+  }
+
+
+
   template <int dim>
   void
   WaveEquationProblem<dim>::output_results ()
@@ -380,7 +496,9 @@ namespace HDG_WE
 	Vector<double> error_estimate(triangulation.n_active_cells());
 	wave_equation_op->estimate_error(solutions, tmp_solutions, error_estimate);
 	data_out.add_data_vector (error_estimate, "Error_estimate");
-	if (parameters.integ_type == IntegratorType::ader_lts)
+	if (parameters.integ_type == IntegratorType::ader_lts ||
+	    parameters.integ_type == IntegratorType::lsrk45reg2_lts ||
+	    parameters.integ_type == IntegratorType::lsrk59reg2_lts)
 	  {
 	    data_out.add_data_vector (clusterids, "cluster_id");
 	    data_out.add_data_vector (timestepsizes, "time_step");
@@ -391,7 +509,7 @@ namespace HDG_WE
 	data_out.add_data_vector (vs, "macrocell_v_index");
 #endif
 	data_out.add_data_vector (dof_handler_post_disp, post_pressure, "post_pressure");
-	data_out.build_patches (mapping, parameters.fe_degree, DataOut<dim>::curved_inner_cells);
+	data_out.build_patches (*mapping, parameters.fe_degree, DataOut<dim>::curved_inner_cells);
 
 	const std::string filename_pressure =
 	  "sol_deg" + Utilities::int_to_string(parameters.fe_degree,1)
@@ -439,7 +557,7 @@ namespace HDG_WE
     Vector<double> norm_per_cell_p (triangulation.n_active_cells());
 
     ComponentSelectFunction<dim> pressure_select(dim, dim+1);
-    VectorTools::integrate_difference (mapping,
+    VectorTools::integrate_difference (*mapping,
                                        dof_handler,
                                        solutions,
                                        ZeroFunction<dim>(dim+1),
@@ -450,7 +568,7 @@ namespace HDG_WE
     double solution_mag = std::sqrt(Utilities::MPI::sum (norm_per_cell_p.norm_sqr(), MPI_COMM_WORLD));
     double solution_norm_p = 0.0, solution_norm_v = 0.0, solution_norm_p_post = 0.0;
 
-    VectorTools::integrate_difference (mapping,
+    VectorTools::integrate_difference (*mapping,
                                        dof_handler,
                                        solutions,
                                        ExactSolution<dim>(dim+1,dim,time_control.get_time(),parameters.initial_cases,parameters.membrane_modes),
@@ -462,7 +580,7 @@ namespace HDG_WE
     last_error_val = solution_norm_p = std::sqrt(Utilities::MPI::sum (norm_per_cell_p.norm_sqr(), MPI_COMM_WORLD));
 
     ComponentSelectFunction<dim> velocity_select(std::pair<unsigned int,unsigned int>(0U, dim), dim+1);
-    VectorTools::integrate_difference (mapping,
+    VectorTools::integrate_difference (*mapping,
                                        dof_handler,
                                        solutions,
                                        ExactSolution<dim>(dim+1,-1,time_control.get_time(),parameters.initial_cases,parameters.membrane_modes),
@@ -474,7 +592,7 @@ namespace HDG_WE
 
     // compute post pressure
     wave_equation_op->compute_post_pressure(solutions, tmp_solutions, post_pressure);
-    VectorTools::integrate_difference (mapping,
+    VectorTools::integrate_difference (*mapping,
                                        dof_handler_post_disp,
                                        post_pressure,
                                        ExactSolution<dim>(1, dim,time_control.get_time(),parameters.initial_cases,parameters.membrane_modes),
@@ -485,7 +603,7 @@ namespace HDG_WE
     solution_norm_p_post = std::sqrt(Utilities::MPI::sum (norm_per_cell_p.norm_sqr(), MPI_COMM_WORLD));
 
     tmp_solutions = 0;
-    VectorTools::integrate_difference (mapping,
+    VectorTools::integrate_difference (*mapping,
                                        dof_handler,
                                        tmp_solutions,
                                        ExactSolution<dim>(dim+1,dim,time_control.get_time(),parameters.initial_cases,parameters.membrane_modes),
@@ -570,32 +688,64 @@ namespace HDG_WE
       case IntegratorType::lsrk59reg2:
       case IntegratorType::ssprk:
       {
-        if (parameters.fe_degree==1)
-          wave_equation_op.reset(new WaveEquationOperation<dim,1>(time_control,parameters));
-        else if (parameters.fe_degree==2)
-          wave_equation_op.reset(new WaveEquationOperation<dim,2>(time_control,parameters));
-        else if (parameters.fe_degree==3)
-          wave_equation_op.reset(new WaveEquationOperation<dim,3>(time_control,parameters));
-        else if (parameters.fe_degree==4)
-          wave_equation_op.reset(new WaveEquationOperation<dim,4>(time_control,parameters));
-        else if (parameters.fe_degree==5)
-          wave_equation_op.reset(new WaveEquationOperation<dim,5>(time_control,parameters));
-        else if (parameters.fe_degree==6)
-          wave_equation_op.reset(new WaveEquationOperation<dim,6>(time_control,parameters));
-        else if (parameters.fe_degree==7)
-          wave_equation_op.reset(new WaveEquationOperation<dim,7>(time_control,parameters));
-        else if (parameters.fe_degree==8)
-          wave_equation_op.reset(new WaveEquationOperation<dim,8>(time_control,parameters));
-        else if (parameters.fe_degree==9)
-          wave_equation_op.reset(new WaveEquationOperation<dim,9>(time_control,parameters));
-        else if (parameters.fe_degree==10)
-          wave_equation_op.reset(new WaveEquationOperation<dim,10>(time_control,parameters));
-        else if (parameters.fe_degree==11)
-          wave_equation_op.reset(new WaveEquationOperation<dim,11>(time_control,parameters));
-        else if (parameters.fe_degree==12)
-          wave_equation_op.reset(new WaveEquationOperation<dim,12>(time_control,parameters));
+        if (parameters.mixed_precision)
+          {
+            if (parameters.fe_degree==1)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,1>(time_control,parameters));
+            else if (parameters.fe_degree==2)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,2>(time_control,parameters));
+            else if (parameters.fe_degree==3)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,3>(time_control,parameters));
+            else if (parameters.fe_degree==4)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,4>(time_control,parameters));
+            else if (parameters.fe_degree==5)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,5>(time_control,parameters));
+            else if (parameters.fe_degree==6)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,6>(time_control,parameters));
+            else if (parameters.fe_degree==7)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,7>(time_control,parameters));
+            else if (parameters.fe_degree==8)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,8>(time_control,parameters));
+            else if (parameters.fe_degree==9)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,9>(time_control,parameters));
+            else if (parameters.fe_degree==10)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,10>(time_control,parameters));
+            else if (parameters.fe_degree==11)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,11>(time_control,parameters));
+            else if (parameters.fe_degree==12)
+              wave_equation_op.reset(new WaveEquationOperationMixed<dim,12>(time_control,parameters));
+            else
+              Assert (false, ExcNotImplemented());
+          }
         else
-          Assert (false, ExcNotImplemented());
+          {
+            if (parameters.fe_degree==1)
+              wave_equation_op.reset(new WaveEquationOperation<dim,1>(time_control,parameters));
+            else if (parameters.fe_degree==2)
+              wave_equation_op.reset(new WaveEquationOperation<dim,2>(time_control,parameters));
+            else if (parameters.fe_degree==3)
+              wave_equation_op.reset(new WaveEquationOperation<dim,3>(time_control,parameters));
+            else if (parameters.fe_degree==4)
+              wave_equation_op.reset(new WaveEquationOperation<dim,4>(time_control,parameters));
+            else if (parameters.fe_degree==5)
+              wave_equation_op.reset(new WaveEquationOperation<dim,5>(time_control,parameters));
+            else if (parameters.fe_degree==6)
+              wave_equation_op.reset(new WaveEquationOperation<dim,6>(time_control,parameters));
+            else if (parameters.fe_degree==7)
+              wave_equation_op.reset(new WaveEquationOperation<dim,7>(time_control,parameters));
+            else if (parameters.fe_degree==8)
+              wave_equation_op.reset(new WaveEquationOperation<dim,8>(time_control,parameters));
+            else if (parameters.fe_degree==9)
+              wave_equation_op.reset(new WaveEquationOperation<dim,9>(time_control,parameters));
+            else if (parameters.fe_degree==10)
+              wave_equation_op.reset(new WaveEquationOperation<dim,10>(time_control,parameters));
+            else if (parameters.fe_degree==11)
+              wave_equation_op.reset(new WaveEquationOperation<dim,11>(time_control,parameters));
+            else if (parameters.fe_degree==12)
+              wave_equation_op.reset(new WaveEquationOperation<dim,12>(time_control,parameters));
+            else
+              Assert (false, ExcNotImplemented());
+          }
         break;
       }
       case IntegratorType::ader:
@@ -659,6 +809,38 @@ namespace HDG_WE
           Assert (false, ExcNotImplemented());
         break;
       }
+      case IntegratorType::lsrk45reg2_lts:
+      case IntegratorType::lsrk59reg2_lts:
+      {
+        // after this call, the variable time_step is set to the biggest time_step of the LTS scheme
+        if (parameters.fe_degree==1)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,1>(time_control,parameters));
+        else if (parameters.fe_degree==2)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,2>(time_control,parameters));
+        else if (parameters.fe_degree==3)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,3>(time_control,parameters));
+        else if (parameters.fe_degree==4)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,4>(time_control,parameters));
+        else if (parameters.fe_degree==5)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,5>(time_control,parameters));
+        else if (parameters.fe_degree==6)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,6>(time_control,parameters));
+        else if (parameters.fe_degree==7)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,7>(time_control,parameters));
+        else if (parameters.fe_degree==8)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,8>(time_control,parameters));
+        else if (parameters.fe_degree==9)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,9>(time_control,parameters));
+        else if (parameters.fe_degree==10)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,10>(time_control,parameters));
+        else if (parameters.fe_degree==11)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,11>(time_control,parameters));
+        else if (parameters.fe_degree==12)
+          wave_equation_op.reset(new WaveEquationOperationRKLTS<dim,12>(time_control,parameters));
+        else
+          Assert (false, ExcNotImplemented());
+        break;
+      }
       case IntegratorType::ader_adconfull:
       {
         if (parameters.fe_degree==1)
@@ -769,6 +951,16 @@ namespace HDG_WE
         integrator.reset(new ArbitraryHighOrderDGLTS<LinearAlgebra::distributed::Vector<value_type>,WaveEquationOperationBase<dim> >());
         break;
       }
+      case IntegratorType::lsrk45reg2_lts:
+      {
+        integrator.reset(new LowStorageRKLTS<LinearAlgebra::distributed::Vector<value_type>,WaveEquationOperationBase<dim> >(5));
+        break;
+      }
+      case IntegratorType::lsrk59reg2_lts:
+      {
+        integrator.reset(new LowStorageRKLTS<LinearAlgebra::distributed::Vector<value_type>,WaveEquationOperationBase<dim> >(9));
+        break;
+      }
       default:
         Assert (false, ExcNotImplemented());
       }
@@ -790,8 +982,20 @@ namespace HDG_WE
           if (time_control.get_step_number() % parameters.adaptive_refinement_interval == 0)
             adapt_mesh();
 
+        if (parameters.load_balancing_interval > 0)
+          if (time_control.get_step_number() % parameters.load_balancing_interval == 0)
+            {
+              const double imbalance = wave_equation_op->load_imbalance();
+              if (imbalance > parameters.load_imbalance_threshold)
+                {
+                  pcout << "   Load imbalance " << imbalance << " at step "
+                        << time_control.get_step_number() << ", repartition" << std::endl;
+                  rebalance_mesh();
+                }
+            }
+
         timer.restart();
-        time_step_analysis(mapping, dof_handler, solutions, time_control.get_time());
+        time_step_analysis(*mapping, dof_handler, solutions, time_control.get_time());
 
         if (time_control.at_tick())
           output_results();
@@ -812,6 +1016,184 @@ namespace HDG_WE
 
   }
 
+#ifdef __linux__
+  // Cores of the NUMA nodes of this machine as listed in
+  // /sys/devices/system/node, as pairs of node number and cores. Nodes
+  // without cores are skipped, and a single node with all cores is returned
+  // if the listing is not available.
+  std::vector<std::pair<unsigned int,std::vector<unsigned int> > >
+  get_numa_nodes(const unsigned int n_cores)
+  {
+    std::vector<std::pair<unsigned int,std::vector<unsigned int> > > nodes;
+    for (unsigned int n=0; ; ++n)
+      {
+        std::ifstream file("/sys/devices/system/node/node" + Utilities::to_string(n) + "/cpulist");
+        if (!file)
+          break;
+
+        // the list has the form 0-7,16-23
+        std::string list, range;
+        std::getline(file, list);
+        std::istringstream ranges(list);
+        std::vector<unsigned int> cores;
+        while (std::getline(ranges, range, ','))
+          {
+            const std::size_t dash = range.find('-');
+            const unsigned int first = std::stoi(range.substr(0, dash));
+            const unsigned int last = dash == std::string::npos ? first :
+                                      std::stoi(range.substr(dash+1));
+            for (unsigned int c=first; c<=last; ++c)
+              cores.push_back(c);
+          }
+        if (!cores.empty())
+          nodes.emplace_back(n, cores);
+      }
+
+    if (nodes.empty())
+      {
+        nodes.emplace_back(0, std::vector<unsigned int>(n_cores));
+        for (unsigned int c=0; c<n_cores; ++c)
+          nodes[0].second[c] = c;
+      }
+    return nodes;
+  }
+
+
+
+#ifdef DEAL_II_WITH_THREADS
+  // Pins each thread joining the TBB scheduler of this rank, including the
+  // main thread, to its own core of the given list in the order the threads
+  // arrive
+  class ThreadPinning : public tbb::task_scheduler_observer
+  {
+  public:
+    ThreadPinning(const std::vector<unsigned int> &cores)
+      :
+      cores(cores),
+      n_entered(0)
+    {
+      observe(true);
+    }
+
+    virtual ~ThreadPinning()
+    {
+      observe(false);
+    }
+
+    virtual void on_scheduler_entry(bool)
+    {
+      cpu_set_t cpus;
+      CPU_ZERO(&cpus);
+      CPU_SET(cores[n_entered++ % cores.size()], &cpus);
+      sched_setaffinity(0, sizeof(cpus), &cpus);
+    }
+
+  private:
+    const std::vector<unsigned int> cores;
+    std::atomic<unsigned int>       n_entered;
+  };
+#endif
+#endif
+
+
+
+  // Set the number of threads of each rank, 0 divides the cores of a node
+  // evenly among its ranks. With pinning, the ranks of a node are spread in
+  // blocks over its NUMA nodes and take consecutive cores of their NUMA
+  // node, one core per thread, before the thread pool is started.
+  void setup_threads(const Parameters &parameters_in)
+  {
+    MPI_Comm node_comm;
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &node_comm);
+    const unsigned int node_rank = Utilities::MPI::this_mpi_process(node_comm);
+    const unsigned int ranks_on_node = Utilities::MPI::n_mpi_processes(node_comm);
+    MPI_Comm_free(&node_comm);
+
+    const unsigned int n_cores = MultithreadInfo::n_cores();
+    const unsigned int n_threads = parameters_in.n_threads > 0 ? parameters_in.n_threads :
+                                   std::max(n_cores/ranks_on_node, 1U);
+
+    std::ostringstream layout;
+    layout << "   Rank " << std::setw(4) << Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)
+           << " on " << Utilities::System::get_hostname();
+#ifdef __linux__
+    const std::vector<std::pair<unsigned int,std::vector<unsigned int> > > numa_nodes =
+      get_numa_nodes(n_cores);
+    if (parameters_in.pin_threads)
+      {
+        // ranks node_rank*n_numa/ranks_on_node share a NUMA node and take
+        // consecutive blocks of its cores
+        const unsigned int n_numa = numa_nodes.size();
+        const unsigned int numa = node_rank*n_numa/ranks_on_node;
+        unsigned int first_rank = node_rank;
+        while (first_rank>0 && (first_rank-1)*n_numa/ranks_on_node == numa)
+          --first_rank;
+        const std::vector<unsigned int> &numa_cores = numa_nodes[numa].second;
+
+        std::vector<unsigned int> thread_cores(n_threads);
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        for (unsigned int t=0; t<n_threads; ++t)
+          {
+            thread_cores[t] = numa_cores[((node_rank-first_rank)*n_threads+t)%numa_cores.size()];
+            CPU_SET(thread_cores[t], &cpus);
+          }
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+          layout << " (pinning failed)";
+#ifdef DEAL_II_WITH_THREADS
+        // the observer has to exist until the threads are gone
+        static std::unique_ptr<ThreadPinning> thread_pinning;
+        thread_pinning.reset(new ThreadPinning(thread_cores));
+#endif
+      }
+#endif
+    MultithreadInfo::set_thread_limit(n_threads);
+    layout << ": " << MultithreadInfo::n_threads() << " threads";
+
+#ifdef __linux__
+    // cores this rank may run on, as ranges, and their NUMA nodes
+    cpu_set_t cpus;
+    if (sched_getaffinity(0, sizeof(cpus), &cpus) == 0)
+      {
+        layout << ", cores ";
+        bool first = true;
+        for (unsigned int c=0; c<CPU_SETSIZE; ++c)
+          if (CPU_ISSET(c, &cpus) && (c==0 || !CPU_ISSET(c-1, &cpus)))
+            {
+              unsigned int last = c;
+              while (last+1<CPU_SETSIZE && CPU_ISSET(last+1, &cpus))
+                ++last;
+              layout << (first ? "" : ",") << c;
+              if (last>c)
+                layout << "-" << last;
+              first = false;
+            }
+
+        layout << ", NUMA node";
+        first = true;
+        for (unsigned int n=0; n<numa_nodes.size(); ++n)
+          for (unsigned int c=0; c<numa_nodes[n].second.size(); ++c)
+            if (CPU_ISSET(numa_nodes[n].second[c], &cpus))
+              {
+                layout << (first ? " " : ",") << numa_nodes[n].first;
+                first = false;
+                break;
+              }
+      }
+#else
+    (void)node_rank;
+#endif
+
+    const std::vector<std::string> layouts = Utilities::MPI::gather(MPI_COMM_WORLD, layout.str());
+    if (Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0)
+      {
+        std::cout << "Thread layout:" << std::endl;
+        for (unsigned int p=0; p<layouts.size(); ++p)
+          std::cout << layouts[p] << std::endl;
+        std::cout << std::endl;
+      }
+  }
+
   void run_cfl_stability_analysis(Parameters &parameters_in)
   {
     ConditionalOStream pcout(std::cout,Utilities::MPI::this_mpi_process(MPI_COMM_WORLD)==0);
@@ -894,6 +1276,7 @@ int main (int argc, char **argv)
 
 #endif
 
+  // the thread pool is sized in setup_threads() once the parameters are read
   Utilities::MPI::MPI_InitFinalize mpi_initialization(argc, argv, 1);
 
   try
@@ -938,6 +1321,7 @@ int main (int argc, char **argv)
         paramfile = "default_parameters.prm";
       Parameters parameters;
       parameters.read_parameters(paramfile);
+      setup_threads(parameters);
 
       if (parameters.dimension == 2)
         {
@@ -39,7 +39,8 @@ void Parameters::declare_parameters (ParameterHandler &prm)
   prm.declare_entry ("dimension","2",Patterns::Integer(),
                      "Defines the dimension of the problem.");
   prm.declare_entry ("boundary_id","2",Patterns::Integer(),
-                     "Boundary condition id.");
+                     "Boundary condition id: 1 soft wall, 2 hard wall, 3 absorbing wall, 0 soft walls "
+                     "at x=0 and x=1, hard wall at y=0 and absorbing walls elsewhere.");
   prm.declare_entry ("grid_transform_factor","0.1",Patterns::Double(),
                      "Distortion of mesh.");
   prm.declare_entry ("fe_degree","2",Patterns::Integer(),
@@ -52,11 +53,17 @@ void Parameters::declare_parameters (ParameterHandler &prm)
                      "Number of adaptive refinements in h-adaptivity.");
   prm.declare_entry ("adaptive_refinement_interval","0",Patterns::Integer(),
                      "Steps for adaptivity update.");
+  prm.declare_entry ("precision","double",Patterns::Selection("double|mixed"),
+                     "Precision of the spatial operator, mixed evaluates it in float with double precision time integration.");
+  prm.declare_entry ("collocation_basis","false",Patterns::Bool(),
+                     "Place the nodes of the DG basis on the Gauss points, which makes the mass matrix diagonal.");
   prm.leave_subsection();
 
   prm.enter_subsection ("TimeDiscretization");
-  prm.declare_entry ("time_integrator","ADER",Patterns::Selection("ExplEuler|clRK4|LSRK45R2|LSRK33R2|LSRK45R3|LSRK59R2|SSPRK|ADER|ADERLTS|ADERADCONFULL"),
-                     "Type of time integrator.");
+  prm.declare_entry ("time_integrator","ADER",Patterns::Selection("ExplEuler|clRK4|LSRK45R2|LSRK33R2|LSRK45R3|LSRK59R2|SSPRK|ADER|ADERLTS|ADERADCONFULL|LSRK45R2LTS|LSRK59R2LTS"),
+                     "Type of time integrator. The multirate schemes LSRK45R2LTS and LSRK59R2LTS "
+                     "interpolate linearly in time between clusters, which is not flux-conservative "
+                     "and limits them to second order in time.");
   prm.declare_entry ("cfl_number","0.1",Patterns::Double(),
                      "Courant number.");
   prm.declare_entry ("max_time_steps","0",Patterns::Integer(),
@@ -69,19 +76,35 @@ void Parameters::declare_parameters (ParameterHandler &prm)
                      "Write VTU output.");
   prm.declare_entry ("cfl_stability_analysis","false",Patterns::Bool(),
                      "Run of a time step stability analysis.");
+  prm.declare_entry ("fused_inverse_mass","false",Patterns::Bool(),
+                     "Apply the inverse mass matrix cell by cell within a cell-centric face loop. "
+                     "For ADER, each cell is corrected as soon as the predictors of its neighbors are done.");
 
   prm.enter_subsection ("ADER");
   prm.declare_entry ("use_ader_post","false",Patterns::Bool(),
-                     "Use of ADER Reconstruction for superconvergence.");
+                     "Use of ADER Reconstruction for superconvergence. With fused_inverse_mass, "
+                     "ADER computes the derivative for the reconstruction inside the predictor sweep. "
+                     "ADERLTS always computes it with a separate full operator evaluation at the "
+                     "start of each time step.");
   prm.declare_entry ("spectral_evaluation","true",Patterns::Bool(),
                      "Spectral evaluation of Taylor-Cauchy-Kowalevski procedure.");
   prm.leave_subsection();
 
   prm.enter_subsection ("ADERLTS");
   prm.declare_entry ("max_n_clusters","10",Patterns::Integer(),
-                     "Number of allowed time step clusters.");
+                     "Number of allowed time step clusters, also used by LSRK45R2LTS and LSRK59R2LTS.");
   prm.declare_entry ("max_diff_clusters","7",Patterns::Integer(),
                      "Allowed time step difference between clusters.");
+  prm.declare_entry ("optimize_clusters","false",Patterns::Bool(),
+                     "Choose number of clusters and time step difference from a cost model, bounded by the two values above.");
+  prm.declare_entry ("interface_overhead","0.5",Patterns::Double(0.),
+                     "Cost of the extra first ADER step of a cluster interface cell relative to a cell update in the "
+                     "cost model. The first ADER step is about half of a cell update, see the timings "
+                     "'ADER CK step' and 'ADER 2nd step' printed at the end of an ADER run.");
+  prm.declare_entry ("reconstruction_cost","1.0",Patterns::Double(0.),
+                     "Cost of the reconstruction for use_ader_post relative to a cell update in the cost model. "
+                     "The reconstruction is an operator evaluation with inverse mass matrix, compare the timings "
+                     "'Evaluate' and 'Inverse mass' to the three ADER timings of an ADER run with use_ader_post.");
   prm.leave_subsection();
 
   prm.leave_subsection();
@@ -93,6 +116,22 @@ void Parameters::declare_parameters (ParameterHandler &prm)
                      "Membrane modes in analytic solution.");
   prm.leave_subsection();
 
+  prm.enter_subsection ("Parallelization");
+  prm.declare_entry ("overlap_communication","false",Patterns::Bool(),
+                     "Overlap the ghost exchange with the cells and faces that need no ghost data. "
+                     "Not available with fused_inverse_mass, where ADER always overlaps and the "
+                     "Runge-Kutta integrators never do.");
+  prm.declare_entry ("load_balancing_interval","0",Patterns::Integer(0),
+                     "Number of time steps between checks of the load balance of ADER LTS, 0 disables the checks.");
+  prm.declare_entry ("load_imbalance_threshold","0.1",Patterns::Double(0.),
+                     "Repartition the mesh with measured cell costs if the slowest rank exceeds the average time by this fraction. "
+                     "The initial repartitioning by cluster weights is skipped below the same fraction of the average weight.");
+  prm.declare_entry ("n_threads","1",Patterns::Integer(0),
+                     "Number of threads per MPI rank, 0 divides the cores of a node evenly among its ranks.");
+  prm.declare_entry ("pin_threads","false",Patterns::Bool(),
+                     "Bind each thread to its own core, with the ranks of a node spread over its NUMA nodes.");
+  prm.leave_subsection();
+
   prm.enter_subsection ("Miscellaneous");
   prm.declare_entry ("output_parameters","true",Patterns::Bool(),
                      "Output all used parameters in the end of the simulation.");
@@ -142,6 +181,8 @@ void Parameters::parse_parameters (const std::string parameter_file,
   adaptive_refinement_interval = prm.get_integer ("adaptive_refinement_interval");
   n_initial_intervals = prm.get_integer ("n_initial_intervals");
   grid_transform_factor = prm.get_double ("grid_transform_factor");
+  mixed_precision = (prm.get ("precision") == "mixed");
+  collocation_basis = prm.get_bool ("collocation_basis");
 
   prm.leave_subsection ();
 
@@ -188,16 +229,31 @@ void Parameters::parse_parameters (const std::string parameter_file,
     {
       integ_type = IntegratorType::ader_adconfull;
     }
+  else if (timestring=="LSRK45R2LTS")
+    {
+      integ_type = IntegratorType::lsrk45reg2_lts;
+    }
+  else if (timestring=="LSRK59R2LTS")
+    {
+      integ_type = IntegratorType::lsrk59reg2_lts;
+    }
   else
     AssertThrow(false,
                 ExcMessage("unknown time integrator " + timestring + " requested"));
 
+  AssertThrow(!mixed_precision || integ_type == IntegratorType::expleuler ||
+              integ_type == IntegratorType::classrk4 || integ_type == IntegratorType::lsrk45reg2 ||
+              integ_type == IntegratorType::lsrk33reg2 || integ_type == IntegratorType::lsrk45reg3 ||
+              integ_type == IntegratorType::lsrk59reg2 || integ_type == IntegratorType::ssprk,
+              ExcMessage("mixed precision is only implemented for the Runge-Kutta integrators"));
+
   cfl_number = prm.get_double("cfl_number")/std::pow(fe_degree,1.5);
   max_time_steps = prm.get_integer("max_time_steps");
   final_time = prm.get_double("final_time");
   output_every_time = prm.get_double("output_every_time");
   write_vtu_output = prm.get_bool("write_vtu_output");
   cfl_stability_analysis = prm.get_bool("cfl_stability_analysis");
+  fused_inverse_mass = prm.get_bool("fused_inverse_mass");
 
   prm.enter_subsection ("ADER");
 
@@ -209,6 +265,9 @@ void Parameters::parse_parameters (const std::string parameter_file,
 
   max_n_clusters = prm.get_integer ("max_n_clusters");
   max_diff_clusters = prm.get_integer ("max_diff_clusters");
+  optimize_clusters = prm.get_bool ("optimize_clusters");
+  interface_overhead = prm.get_double ("interface_overhead");
+  reconstruction_cost = prm.get_double ("reconstruction_cost");
 
   prm.leave_subsection();
 
@@ -221,6 +280,23 @@ void Parameters::parse_parameters (const std::string parameter_file,
 
   prm.leave_subsection();
 
+  prm.enter_subsection ("Parallelization");
+
+  overlap_communication = prm.get_bool ("overlap_communication");
+  load_balancing_interval = prm.get_integer ("load_balancing_interval");
+  load_imbalance_threshold = prm.get_double ("load_imbalance_threshold");
+  n_threads = prm.get_integer ("n_threads");
+  pin_threads = prm.get_bool ("pin_threads");
+
+  prm.leave_subsection();
+
+  // the fused Runge-Kutta apply reads the neighbors of a cell in the cell
+  // loop, which only starts after the complete ghost exchange, and the fused
+  // ADER apply always overlaps its exchange
+  AssertThrow(!overlap_communication || !fused_inverse_mass,
+              ExcMessage("overlap_communication has no effect with fused_inverse_mass, "
+                         "enable only one of them"));
+
   prm.enter_subsection ("Miscellaneous");
 
   output_of_parameters = prm.get_bool ("output_parameters");
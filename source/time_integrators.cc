@@ -56,8 +56,10 @@ void ArbitraryHighOrderDGLTS<VectorType,Operator>::perform_time_step(VectorType
     const double              ,
     Operator                  &op)
 {
-  // apply ader lts scheme
-  op.apply_ader(vec_n,vec_np);
+  // the ader lts scheme advances the solution in place, so hand the old
+  // solution over to vec_np instead of copying it
+  vec_np.swap(vec_n);
+  op.apply_ader(vec_np,vec_np);
 
   return;
 }
@@ -71,8 +73,8 @@ void ClassRK4<VectorType,Operator>::perform_time_step(VectorType &vec_n,
 {
   if (!vec_tmp1.partitioners_are_globally_compatible(*vec_n.get_partitioner()))
     {
-      vec_tmp1.reinit(vec_np);
-      vec_tmp2.reinit(vec_np, true);
+      op.initialize_dof_vector(vec_tmp1);
+      op.initialize_dof_vector(vec_tmp2);
     }
 
   // stage 1
@@ -193,6 +195,40 @@ namespace
 
     const RKVectorUpdater<Number> updater;
   };
+
+  // One low-storage Runge-Kutta stage with the same update as
+  // RKVectorUpdatesRange. If the operator supports it, the update is applied
+  // cell by cell right after the inverse mass matrix and the stage derivative
+  // is never written to memory. Neighbors still read the source vector while
+  // the cells are updated, so an output coinciding with src is written into
+  // vec_tmp and swapped in afterwards.
+  template <typename VectorType, typename Operator>
+  void fused_rk_stage(Operator         &op,
+                      const double      factor1,
+                      const double      factor2,
+                      const bool        is_last,
+                      const VectorType &src,
+                      VectorType       &vector2,
+                      VectorType       &vector3,
+                      VectorType       &vec_tmp)
+  {
+    const bool swap2 = (&vector2 == &src);
+    const bool swap3 = !is_last && (&vector3 == &src);
+    const LowStorageRKStageUpdate<VectorType> update(factor1, factor2, is_last,
+                                                     is_last ? vector3 : vector2,
+                                                     swap2 ? vec_tmp : vector2,
+                                                     swap3 ? vec_tmp : vector3);
+    if (op.apply_and_update(src, vec_tmp, update))
+      {
+        if (swap2)
+          vector2.swap(vec_tmp);
+        else if (swap3)
+          vector3.swap(vec_tmp);
+      }
+    else
+      RKVectorUpdatesRange<typename VectorType::value_type>(factor1, factor2, is_last,
+                                                            vec_tmp, vector2, vector3);
+  }
 }
 
 
@@ -212,22 +248,18 @@ void LowStorageRK33Reg2<VectorType,Operator>::perform_time_step(VectorType &vec_
 
   if (!vec_tmp1.partitioners_are_globally_compatible(*vec_n.get_partitioner()))
     {
-      vec_tmp1.reinit(vec_np);
+      op.initialize_dof_vector(vec_tmp1);
     }
 
-  typedef typename VectorType::value_type value_type;
   //stage 1
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a21*time_step, (b1-a21)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a21*time_step, (b1-a21)*time_step, false,
+                 vec_n, vec_n, vec_np, vec_tmp1);
   // stage 2
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a32*time_step, (b2-a32)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a32*time_step, (b2-a32)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
   // stage 3
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(b3*time_step, 0, true,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, b3*time_step, 0, true,
+                 vec_np, vec_np, vec_n, vec_tmp1);
 }
 
 
@@ -238,8 +270,6 @@ void LowStorageRK45Reg2<VectorType,Operator>::perform_time_step(VectorType &vec_
     const double             time_step,
     Operator                 &op)
 {
-  typedef typename Operator::value_type value_type;
-
   const double a21 = 970286171893./4311952581923.;
   const double a32 = 6584761158862./12103376702013.;
   const double a43 = 2251764453980./15575788980749.;
@@ -253,33 +283,28 @@ void LowStorageRK45Reg2<VectorType,Operator>::perform_time_step(VectorType &vec_
 
   if (!vec_tmp1.partitioners_are_globally_compatible(*vec_n.get_partitioner()))
     {
-      vec_tmp1.reinit(vec_np);
+      op.initialize_dof_vector(vec_tmp1);
     }
 
   // stage 1
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a21*time_step, (b1-a21)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a21*time_step, (b1-a21)*time_step, false,
+                 vec_n, vec_n, vec_np, vec_tmp1);
 
   // stage 2
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a32*time_step, (b2-a32)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a32*time_step, (b2-a32)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 3
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a43*time_step, (b3-a43)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a43*time_step, (b3-a43)*time_step, false,
+                 vec_np, vec_n, vec_np, vec_tmp1);
 
   // stage 4
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a54*time_step, (b4-a54)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a54*time_step, (b4-a54)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 5
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(b5*time_step, 0, true,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, b5*time_step, 0, true,
+                 vec_np, vec_np, vec_n, vec_tmp1);
 }
 
 
@@ -289,8 +314,6 @@ void LowStorageRK59Reg2<VectorType,Operator>::perform_time_step(VectorType &vec_
     const double             time_step,
     Operator                 &op)
 {
-  typedef typename Operator::value_type value_type;
-
   const double a21 = 1107026461565./5417078080134.;
   const double a32 = 38141181049399./41724347789894.;
   const double a43 = 493273079041./11940823631197.;
@@ -313,56 +336,106 @@ void LowStorageRK59Reg2<VectorType,Operator>::perform_time_step(VectorType &vec_
 
   if (!vec_tmp1.partitioners_are_globally_compatible(*vec_n.get_partitioner()))
     {
-      vec_tmp1.reinit(vec_np);
+      op.initialize_dof_vector(vec_tmp1);
     }
 
   // stage 1
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a21*time_step, (b1-a21)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a21*time_step, (b1-a21)*time_step, false,
+                 vec_n, vec_n, vec_np, vec_tmp1);
 
   // stage 2
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a32*time_step, (b2-a32)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a32*time_step, (b2-a32)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 3
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a43*time_step, (b3-a43)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a43*time_step, (b3-a43)*time_step, false,
+                 vec_np, vec_n, vec_np, vec_tmp1);
 
   // stage 4
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a54*time_step, (b4-a54)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a54*time_step, (b4-a54)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 5
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a65*time_step, (b5-a65)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a65*time_step, (b5-a65)*time_step, false,
+                 vec_np, vec_n, vec_np, vec_tmp1);
 
   // stage 6
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a76*time_step, (b6-a76)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a76*time_step, (b6-a76)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 7
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a87*time_step, (b7-a87)*time_step, false,
-                                   vec_tmp1, vec_n, vec_np);
+  fused_rk_stage(op, a87*time_step, (b7-a87)*time_step, false,
+                 vec_np, vec_n, vec_np, vec_tmp1);
 
   // stage 8
-  op.apply(vec_n, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(a98*time_step, (b8-a98)*time_step, false,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, a98*time_step, (b8-a98)*time_step, false,
+                 vec_n, vec_np, vec_n, vec_tmp1);
 
   // stage 9
-  op.apply(vec_np, vec_tmp1);
-  RKVectorUpdatesRange<value_type>(b9*time_step, 0, true,
-                                   vec_tmp1, vec_np, vec_n);
+  fused_rk_stage(op, b9*time_step, 0, true,
+                 vec_np, vec_np, vec_n, vec_tmp1);
 }
 
 
+template <typename VectorType, typename Operator>
+LowStorageRKLTS<VectorType,Operator>::LowStorageRKLTS(const unsigned int stages)
+{
+  // same coefficients as LowStorageRK45Reg2 and LowStorageRK59Reg2
+  if (stages == 5)
+    {
+      stage_factors = {970286171893./4311952581923.,
+                       6584761158862./12103376702013.,
+                       2251764453980./15575788980749.,
+                       26877169314380./34165994151039.
+                      };
+      weights = {1153189308089./22510343858157.,
+                 1772645290293./ 4653164025191.,
+                 -1672844663538./ 4480602732383.,
+                 2114624349019./3568978502595.,
+                 5198255086312./14908931495163.
+                };
+    }
+  else if (stages == 9)
+    {
+      stage_factors = {1107026461565./5417078080134.,
+                       38141181049399./41724347789894.,
+                       493273079041./11940823631197.,
+                       1851571280403./6147804934346.,
+                       11782306865191./62590030070788.,
+                       9452544825720./13648368537481.,
+                       4435885630781./26285702406235.,
+                       2357909744247./11371140753790.
+                      };
+      weights = {2274579626619./23610510767302.,
+                 693987741272./12394497460941.,
+                 -347131529483./15096185902911.,
+                 1144057200723./32081666971178.,
+                 1562491064753./11797114684756.,
+                 13113619727965./44346030145118.,
+                 393957816125./7825732611452.,
+                 720647959663./6565743875477.,
+                 3559252274877./14424734981077.
+                };
+    }
+  else
+    AssertThrow(false, ExcNotImplemented());
+}
+
+
+
+template <typename VectorType, typename Operator>
+void LowStorageRKLTS<VectorType,Operator>::perform_time_step(VectorType &vec_n,
+    VectorType &vec_np,
+    const double             ,
+    Operator                &op)
+{
+  // the clusters advance the solution in place with their own time steps
+  vec_np.swap(vec_n);
+  op.apply_multirate_rk(stage_factors, weights, vec_np);
+}
+
+
+
 template <typename VectorType, typename Operator>
 void LowStorageRK45Reg3<VectorType,Operator>::perform_time_step(VectorType &vec_n,
     VectorType &vec_np,
@@ -386,8 +459,8 @@ void LowStorageRK45Reg3<VectorType,Operator>::perform_time_step(VectorType &vec_
 
   if (!vec_tmp1.partitioners_are_globally_compatible(*vec_n.get_partitioner()))
     {
-      vec_tmp1.reinit(vec_np, true);
-      vec_tmp2.reinit(vec_np, true);
+      op.initialize_dof_vector(vec_tmp1);
+      op.initialize_dof_vector(vec_tmp2);
     }
 
   // stage 1 -- begin
@@ -451,13 +524,13 @@ void SSPRK<VectorType,Operator>::perform_time_step (VectorType &vec_n,
     {
       vec_tmp1.resize(stages+1);
       for (unsigned int d=0; d<vec_tmp1.size(); ++d)
-        vec_tmp1[d].reinit(vec_n, true);
+        op.initialize_dof_vector(vec_tmp1[d]);
       
       //vec_tmp2.reinit(vec_n, true);
       
       vec_tmp3.resize(stages+1);
       for (unsigned int d=0; d<vec_tmp3.size(); ++d)
-        vec_tmp3[d].reinit(vec_n, true);
+        op.initialize_dof_vector(vec_tmp3[d]);
     }
 
   vec_tmp1[0] = vec_n;
@@ -882,6 +955,8 @@ template class LowStorageRK45Reg3<dealii::LinearAlgebra::distributed::Vector<dou
 template class LowStorageRK45Reg3<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<3> >;
 template class LowStorageRK59Reg2<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<2> >;
 template class LowStorageRK59Reg2<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<3> >;
+template class LowStorageRKLTS<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<2> >;
+template class LowStorageRKLTS<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<3> >;
 template class SSPRK<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<2> >;
 template class SSPRK<dealii::LinearAlgebra::distributed::Vector<double>, HDG_WE::WaveEquationOperationBase<3> >;
 
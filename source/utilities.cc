@@ -111,6 +111,20 @@ namespace HDG_WE
   }
 
 
+  template <int dim>
+  template <typename Number>
+  VectorizedArray<Number> ExactSolution<dim>::value (const Point<dim,VectorizedArray<Number> > &p,
+                                                     const unsigned int                         c) const
+  {
+    double t = this->get_time();
+
+    if (component<0)
+      return input_exact_solution(p,t,c,false,initial_cases,membrane_modes);
+    else
+      return input_exact_solution(p,t,component,false,initial_cases,membrane_modes);
+  }
+
+
   template <int dim>
   double ExactSolutionTimeDerivative<dim>::value (const Point<dim>   &p,
                                                   const unsigned int c) const
@@ -129,5 +143,9 @@ namespace HDG_WE
 
   template class ExactSolution<2>;
   template class ExactSolution<3>;
+  template VectorizedArray<double> ExactSolution<2>::value(const Point<2,VectorizedArray<double> > &, const unsigned int) const;
+  template VectorizedArray<double> ExactSolution<3>::value(const Point<3,VectorizedArray<double> > &, const unsigned int) const;
+  template VectorizedArray<float> ExactSolution<2>::value(const Point<2,VectorizedArray<float> > &, const unsigned int) const;
+  template VectorizedArray<float> ExactSolution<3>::value(const Point<3,VectorizedArray<float> > &, const unsigned int) const;
 
 }
@@ -14,8 +14,11 @@
 // --------------------------------------------------------------------------
 
 #include <deal.II/base/conditional_ostream.h>
+#include <deal.II/base/parallel.h>
 #include <deal.II/fe/fe_dgq.h>
 #include <deal.II/base/timer.h>
+#include <atomic>
+#include <set>
 
 #include "../include/wave_equation_operations.h"
 
@@ -25,9 +28,11 @@ namespace HDG_WE
   template <int dim, int fe_degree, typename Number>
   InverseMassMatrixData<dim,fe_degree,Number>::InverseMassMatrixData(const MatrixFree<dim,Number> &data)
     :
-    phi(1, FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,Number>(data)),
+    phi(2, FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,Number>(data)),
     coefficients(phi[0].n_q_points),
-    inverse(phi[0])
+    inverse(phi[0]),
+    collocation(data.get_shape_info().element_type ==
+                internal::MatrixFreeFunctions::tensor_symmetric_collocation)
   {}
 
   template <int dim, int fe_degree, typename Number>
@@ -35,12 +40,44 @@ namespace HDG_WE
     :
     phi(other.phi),
     coefficients(other.coefficients),
-    inverse(phi[0])
+    inverse(phi[0]),
+    collocation(other.collocation)
   {}
 
+  template <int dim, int fe_degree, typename Number>
+  void InverseMassMatrixData<dim,fe_degree,Number>::
+  apply(const VectorizedArray<Number> *in_array,
+        VectorizedArray<Number>       *out_array) const
+  {
+    if (collocation)
+      {
+        constexpr unsigned int dofs_per_component = Utilities::pow(fe_degree+1,dim);
+        for (unsigned int d=0; d<dim+1; ++d)
+          for (unsigned int i=0; i<dofs_per_component; ++i)
+            out_array[d*dofs_per_component+i] = in_array[d*dofs_per_component+i] * coefficients[i];
+      }
+    else
+      inverse.apply(coefficients, dim+1, in_array, out_array);
+  }
 
-  template<int dim, int fe_degree>
-  WaveEquationOperation<dim,fe_degree>::~WaveEquationOperation()
+  template <int dim, int fe_degree, typename Number>
+  void InverseMassMatrixData<dim,fe_degree,Number>::
+  transform_from_q_points_to_basis(const VectorizedArray<Number> *in_array,
+                                   VectorizedArray<Number>       *out_array) const
+  {
+    if (collocation)
+      {
+        constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          out_array[i] = in_array[i];
+      }
+    else
+      inverse.transform_from_q_points_to_basis(dim+1, in_array, out_array);
+  }
+
+
+  template<int dim, int fe_degree, typename Number>
+  WaveEquationOperation<dim,fe_degree,Number>::~WaveEquationOperation()
   {
     ConditionalOStream pcout(std::cout, Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0);
     Utilities::MPI::MinMaxAvg data;
@@ -98,49 +135,128 @@ namespace HDG_WE
         pcout<<" call of invmass in apply          "<< std::scientific << std::setw(4) << Utilities::MPI::max(computing_times[1], MPI_COMM_WORLD)<<std::endl;
         pcout<<" call of domain and faces in apply "<< std::scientific << std::setw(4) << Utilities::MPI::max(computing_times[0], MPI_COMM_WORLD)<<std::endl;
       }
+
+    // hidden latency per loop: the separate exchange plus computation time
+    // of the sampled loops minus the time of the overlapped loops
+    const char *loop_names[] = {"apply    ", "ADER corr"};
+    for (unsigned int i=0; i<communication_statistics.size(); ++i)
+      {
+        const CommunicationStatistics &stat = communication_statistics[i];
+        if (stat.n_samples == 0 || stat.n_overlapped == 0)
+          continue;
+        const double exchange = stat.exchange_time/stat.n_samples;
+        const double hidden = std::max(0., exchange + stat.compute_time/stat.n_samples
+                                       - stat.overlap_time/stat.n_overlapped);
+        pcout << "   Comm " << loop_names[i] << ": ";
+        data = Utilities::MPI::min_max_avg(exchange, MPI_COMM_WORLD);
+        pcout << "exchange " << std::scientific << std::setw(9) << data.avg;
+        data = Utilities::MPI::min_max_avg(hidden, MPI_COMM_WORLD);
+        pcout << ", hidden " << std::setw(9) << data.min
+              << " (p" << std::setw(4) << data.min_index << ") "
+              << std::setw(9) << data.avg
+              <<  std::setw(9) << data.max
+              << " (p" << std::setw(4) << data.max_index << ")"
+              << " per loop, " << stat.n_samples << " samples" << std::endl;
+      }
   }
 
 
-  template<int dim, int fe_degree>
-  std::string WaveEquationOperation<dim,fe_degree>::Name()
+
+  template<int dim, int fe_degree, typename Number>
+  template <typename LoopType>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  timed_loop(const LoopType                                       &loop,
+             const LinearAlgebra::distributed::Vector<value_type> &src,
+             const unsigned int                                    index) const
+  {
+    if (!parameters.overlap_communication)
+      {
+        loop();
+        return;
+      }
+
+    const unsigned int sample_interval = 100;
+    CommunicationStatistics &stat = communication_statistics[index];
+    Timer timer;
+    if ((stat.n_samples+stat.n_overlapped) % sample_interval == 0)
+      {
+        // time the exchange of the loop, which only sends the dofs on the
+        // faces through the partitioner for DataAccessOnFaces::values, into
+        // scratch memory
+        const std::shared_ptr<const Utilities::MPI::Partitioner> &face_partitioner =
+          data.get_dof_info(0).vector_partitioner_face_variants[1];
+        const Utilities::MPI::Partitioner &partitioner =
+          face_partitioner.get() != nullptr ? *face_partitioner : *src.get_partitioner();
+        std::vector<value_type> import_data(partitioner.n_import_indices());
+        std::vector<value_type> ghost_data(src.get_partitioner()->n_ghost_indices());
+        std::vector<MPI_Request> requests;
+        timer.restart();
+        partitioner.export_to_ghosted_array_start(0,
+                                                  ArrayView<const value_type>(src.begin(), partitioner.local_size()),
+                                                  ArrayView<value_type>(import_data.data(), import_data.size()),
+                                                  ArrayView<value_type>(ghost_data.data(), ghost_data.size()),
+                                                  requests);
+        partitioner.export_to_ghosted_array_finish(ArrayView<value_type>(ghost_data.data(), ghost_data.size()),
+                                                   requests);
+        stat.exchange_time += timer.wall_time();
+
+        // the loop finds the ghosts already set and skips its own exchange
+        src.update_ghost_values();
+        timer.restart();
+        loop();
+        stat.compute_time += timer.wall_time();
+        src.zero_out_ghosts();
+        ++stat.n_samples;
+      }
+    else
+      {
+        loop();
+        stat.overlap_time += timer.wall_time();
+        ++stat.n_overlapped;
+      }
+  }
+
+
+  template<int dim, int fe_degree, typename Number>
+  std::string WaveEquationOperation<dim,fe_degree,Number>::Name()
   {
     return "Runge-Kutta";
   }
 
-  template<int dim, int fe_degree>
-  const MatrixFree<dim,typename WaveEquationOperationBase<dim>::value_type> &WaveEquationOperation<dim,fe_degree>::get_matrix_free() const
+  template<int dim, int fe_degree, typename Number>
+  const MatrixFree<dim,typename WaveEquationOperationBase<dim,Number>::value_type> &WaveEquationOperation<dim,fe_degree,Number>::get_matrix_free() const
   {
     return data;
   }
 
-  template<int dim, int fe_degree>
-  TimeControl &WaveEquationOperation<dim,fe_degree>::get_time_control() const
+  template<int dim, int fe_degree, typename Number>
+  TimeControl &WaveEquationOperation<dim,fe_degree,Number>::get_time_control() const
   {
     return time_control;
   }
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
                                                          LinearAlgebra::distributed::Vector<value_type> &) const
   {
     AssertThrow(false,ExcNotImplemented());
   }
 
 
-  template<int dim, int fe_degree>
-  unsigned int WaveEquationOperation<dim,fe_degree>::cluster_id(unsigned int) const
+  template<int dim, int fe_degree, typename Number>
+  unsigned int WaveEquationOperation<dim,fe_degree,Number>::cluster_id(unsigned int) const
   {
     return -1;
   }
 
-  template<int dim, int fe_degree>
-  typename WaveEquationOperationBase<dim>::value_type WaveEquationOperation<dim,fe_degree>::time_step(unsigned int ) const
+  template<int dim, int fe_degree, typename Number>
+  typename WaveEquationOperationBase<dim,Number>::value_type WaveEquationOperation<dim,fe_degree,Number>::time_step(unsigned int ) const
   {
     return time_control.get_time_step();
   }
 
-  template<int dim, int fe_degree>
-  typename WaveEquationOperationBase<dim>::value_type WaveEquationOperation<dim,fe_degree>::speed_of_sound(int cell_index, int vect_index) const
+  template<int dim, int fe_degree, typename Number>
+  typename WaveEquationOperationBase<dim,Number>::value_type WaveEquationOperation<dim,fe_degree,Number>::speed_of_sound(int cell_index, int vect_index) const
   {
     return speeds[cell_index][vect_index];
   }
@@ -178,27 +294,36 @@ namespace HDG_WE
     return cluster_manager.get_cell_time_step(cell);
   }
 
+  template<int dim, int fe_degree>
+  double WaveEquationOperationADERLTS<dim,fe_degree>::load_imbalance() const
+  {
+    return cluster_manager.load_imbalance();
+  }
+
   template<int dim, int fe_degree>
   void WaveEquationOperationADERLTS<dim,fe_degree>::communicate_flux_memory() const
   {
-    flux_memory.compress(VectorOperation::add);
-    return;
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    cluster_manager.exchange_flux_memory(flux_memory,dofs_per_cell);
   }
 
 
-  template<int dim, int fe_degree>
-  WaveEquationOperation<dim,fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  WaveEquationOperation<dim,fe_degree,Number>::
   WaveEquationOperation(TimeControl &time_control_in, Parameters &parameters_in)
     :
     time_control(time_control_in),
     parameters(parameters_in),
-    computing_times(23)
+    use_fused_apply(false),
+    stage_update(nullptr),
+    computing_times(23),
+    communication_statistics(2)
   {}
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   setup(const MappingQGeneric<dim>                 &mapping,
         const std::vector<const DoFHandler<dim> *> &dof_handlers,
         const std::vector<Material>                &mats,
@@ -223,16 +348,24 @@ namespace HDG_WE
     additional_data.tasks_parallel_scheme =
       MatrixFree<dim,value_type>::AdditionalData::partition_partition;
     additional_data.hold_all_faces_to_owned_cells = true;
-    additional_data.overlap_communication_computation = false;
+    additional_data.overlap_communication_computation = parameters.overlap_communication;
+    // quadrature points are only needed on cells for projecting the initial
+    // field; faces only need normals and JxW, which keeps the face geometry
+    // of affine and Cartesian batches at a single entry per face
     additional_data.mapping_update_flags = (update_gradients | update_JxW_values |
                                             update_quadrature_points |
                                             update_values);
     additional_data.mapping_update_flags_inner_faces = (update_JxW_values |
-                                                        update_quadrature_points | update_normal_vectors |
+                                                        update_normal_vectors |
                                                         update_values);
     additional_data.mapping_update_flags_boundary_faces = (update_JxW_values |
-                                                           update_quadrature_points | update_normal_vectors |
+                                                           update_normal_vectors |
                                                            update_values);
+    // the fused apply evaluates the faces from both adjacent cells
+    if (parameters.fused_inverse_mass)
+      additional_data.mapping_update_flags_faces_by_cells = (update_JxW_values |
+                                                             update_normal_vectors |
+                                                             update_values);
     additional_data.initialize_mapping = false;
     additional_data.cell_vectorization_category = vectorization_categories;
     additional_data.cell_vectorization_categories_strict = true;
@@ -245,7 +378,21 @@ namespace HDG_WE
     additional_data.initialize_mapping = true;
     data.reinit(mapping,dof_handlers,constraints,quadratures,additional_data);
 
-    mass_matrix_data.reset(new InverseMassMatrixData<dim,fe_degree,value_type>(data));
+    // report how many cell batches run with constant-Jacobian geometry
+    {
+      unsigned int n_batches[3] = {0, 0, 0};
+      for (unsigned int cell=0; cell<data.n_macro_cells(); ++cell)
+        ++n_batches[std::min(static_cast<unsigned int>(data.get_mapping_info().get_cell_type(cell)), 2U)];
+      ConditionalOStream pcout(std::cout, Utilities::MPI::this_mpi_process(MPI_COMM_WORLD) == 0);
+      pcout << "Cell batches: "
+            << Utilities::MPI::sum(n_batches[0], MPI_COMM_WORLD) << " Cartesian, "
+            << Utilities::MPI::sum(n_batches[1], MPI_COMM_WORLD) << " affine, "
+            << Utilities::MPI::sum(n_batches[2], MPI_COMM_WORLD) << " general"
+            << std::endl;
+    }
+
+    mass_matrix_data.reset(new Threads::ThreadLocalStorage<InverseMassMatrixData<dim,fe_degree,value_type> >
+                           (InverseMassMatrixData<dim,fe_degree,value_type>(data)));
     reset_data_vectors(mats);
   }
 
@@ -316,6 +463,50 @@ namespace HDG_WE
 
     // initialize vector for temporary values
     this->data.initialize_dof_vector(tempsrc);
+
+    // Dependencies of the task graph in apply_ader(): the corrector of a
+    // cell batch reads the predictor of the batch itself and of its face
+    // neighbors, and waits for the ghost exchange if a neighbor is a ghost
+    constexpr unsigned int n_vect = VectorizedArray<value_type>::n_array_elements;
+    const unsigned int n_batches = this->data.n_macro_cells();
+    std::vector<std::set<unsigned int> > neighbor_batches(n_batches);
+    std::vector<bool> has_ghost_neighbor(n_batches, false);
+    for (unsigned int b=0; b<n_batches; ++b)
+      neighbor_batches[b].insert(b);
+    for (unsigned int f=0; f<this->data.n_inner_face_batches(); ++f)
+      for (unsigned int v=0; v<n_vect &&
+           this->data.get_face_info(f).cells_interior[v]!=numbers::invalid_unsigned_int; ++v)
+        {
+          const unsigned int interior = this->data.get_face_info(f).cells_interior[v]/n_vect;
+          const unsigned int exterior = this->data.get_face_info(f).cells_exterior[v]/n_vect;
+          if (interior<n_batches && exterior<n_batches)
+            {
+              neighbor_batches[interior].insert(exterior);
+              neighbor_batches[exterior].insert(interior);
+            }
+          else if (interior<n_batches)
+            has_ghost_neighbor[interior] = true;
+          else if (exterior<n_batches)
+            has_ghost_neighbor[exterior] = true;
+        }
+
+    dependent_batches.resize(n_batches);
+    n_dependencies.resize(n_batches);
+    ghost_neighbor_batches.clear();
+    for (unsigned int b=0; b<n_batches; ++b)
+      {
+        dependent_batches[b].assign(neighbor_batches[b].begin(), neighbor_batches[b].end());
+        n_dependencies[b] = dependent_batches[b].size() + (has_ghost_neighbor[b] ? 1 : 0);
+        if (has_ghost_neighbor[b])
+          ghost_neighbor_batches.push_back(b);
+      }
+    // the batches sending to other ranks are predicted first, such that the
+    // ghost exchange overlaps with the remaining batches
+    batch_order = ghost_neighbor_batches;
+    for (unsigned int b=0; b<n_batches; ++b)
+      if (!has_ghost_neighbor[b])
+        batch_order.push_back(b);
+    pending_dependencies.reset(new std::atomic<unsigned int>[n_batches]);
   }
 
 
@@ -324,7 +515,9 @@ namespace HDG_WE
   WaveEquationOperationADERADCONFULL<dim,fe_degree>::
   WaveEquationOperationADERADCONFULL(TimeControl &time_control_in,
                                      Parameters  &parameters_in)
-    : WaveEquationOperation<dim,fe_degree>(time_control_in,parameters_in)
+    : WaveEquationOperation<dim,fe_degree>(time_control_in,parameters_in),
+    taylor_factor(0.),
+    first_taylor_term(true)
   {}
 
 
@@ -340,6 +533,7 @@ namespace HDG_WE
     WaveEquationOperation<dim,fe_degree>::setup(mapping,dof_handlers,mats,vectorization_categories);
 
     this->data.initialize_dof_vector(tempsrc);
+    this->data.initialize_dof_vector(tempvals);
   }
 
 
@@ -361,6 +555,11 @@ namespace HDG_WE
   {
     // call base class setup
     std::vector<unsigned int> new_vec_categors;
+    if (this->parameters.optimize_clusters)
+      cluster_manager.enable_cluster_optimization(this->parameters.use_ader_post,
+                                                  this->parameters.interface_overhead,
+                                                  this->parameters.reconstruction_cost);
+    cluster_manager.set_repartition_threshold(this->parameters.load_imbalance_threshold);
     cluster_manager.propose_cluster_categorization(new_vec_categors,
                                                    dof_handlers[0]->get_triangulation(),
                                                    dof_handlers,
@@ -369,40 +568,85 @@ namespace HDG_WE
                                                    this->parameters.cfl_number);
     WaveEquationOperationADER<dim,fe_degree>::setup(mapping,dof_handlers,mats,new_vec_categors);
 
-    // initialize flux memory
-    this->data.initialize_dof_vector(flux_memory);
-    cluster_manager.state = flux_memory;
+    this->data.initialize_dof_vector(cluster_manager.face_contributions);
     if (this->parameters.use_ader_post)
-      cluster_manager.improvedgraddiv = flux_memory;
+      cluster_manager.improvedgraddiv.reinit(cluster_manager.face_contributions);
+
+    // tempsrc was zeroed by the base class setup
+    tempsrc_cells.clear();
 
     cluster_manager.setup(*this);
+
+    // the flux memory only covers the cell batches at cluster interfaces
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    flux_memory.clear();
+    flux_memory.resize(cluster_manager.n_flux_memory_cells()*dofs_per_cell,
+                       make_vectorized_array<value_type>(0.));
   }
 
 
 
-  template <int dim, int fe_degree>
+  template <int dim, int fe_degree, typename Number>
   void
-  WaveEquationOperation<dim,fe_degree>::reset_data_vectors(const std::vector<Material> mats)
+  WaveEquationOperation<dim,fe_degree,Number>::reset_data_vectors(const std::vector<Material> mats)
   {
-    densities.resize(data.n_macro_cells()+data.n_ghost_cell_batches());
-    speeds.resize(data.n_macro_cells()+data.n_ghost_cell_batches());
-
-    for (unsigned int i=0; i<data.n_macro_cells()+data.n_ghost_cell_batches(); ++i)
-      {
-        densities[i] = 1.;
-        speeds[i] = 1.;
-        for (unsigned int v=0; v<data.n_components_filled(i); ++v)
+    // the arrays are filled by the worker threads, such that their pages are
+    // not all placed on the NUMA node of the main thread
+    const unsigned int n_cell_batches = data.n_macro_cells()+data.n_ghost_cell_batches();
+    densities.resize_fast(n_cell_batches);
+    speeds.resize_fast(n_cell_batches);
+    parallel::apply_to_subranges(0U, n_cell_batches,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int i=begin; i<end; ++i)
+        {
+          densities[i] = 1.;
+          speeds[i] = 1.;
+          for (unsigned int v=0; v<data.n_components_filled(i); ++v)
+            {
+              densities[i][v] = mats[data.get_cell_iterator(i,v)->material_id()].density;
+              speeds[i][v] = mats[data.get_cell_iterator(i,v)->material_id()].speed;
+            }
+        }
+    }, cell_grain_size);
+
+    // material behind each face, the own material on boundary faces and in
+    // unfilled lanes
+    const unsigned int n_faces = GeometryInfo<dim>::faces_per_cell;
+    face_densities.resize_fast(data.n_macro_cells()*n_faces);
+    face_speeds.resize_fast(data.n_macro_cells()*n_faces);
+    std::atomic<bool> conforming(true);
+    parallel::apply_to_subranges(0U, data.n_macro_cells(),
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      for (unsigned int i=begin; i<end; ++i)
+        for (unsigned int f=0; f<n_faces; ++f)
           {
-            densities[i][v] = mats[data.get_cell_iterator(i,v)->material_id()].density;
-            speeds[i][v] = mats[data.get_cell_iterator(i,v)->material_id()].speed;
+            face_densities[i*n_faces+f] = densities[i];
+            face_speeds[i*n_faces+f] = speeds[i];
+            for (unsigned int v=0; v<data.n_components_filled(i); ++v)
+              {
+                const typename DoFHandler<dim>::cell_iterator cell = data.get_cell_iterator(i,v);
+                if (cell->at_boundary(f))
+                  continue;
+                if (cell->neighbor_is_coarser(f) || cell->neighbor(f)->has_children())
+                  conforming = false;
+                face_densities[i*n_faces+f][v] = mats[cell->neighbor(f)->material_id()].density;
+                face_speeds[i*n_faces+f][v] = mats[cell->neighbor(f)->material_id()].speed;
+              }
           }
-      }
+    }, cell_grain_size);
+
+    // faces by cells do not represent hanging neighbors, so fall back to the
+    // face loop on adaptively refined meshes
+    use_fused_apply = parameters.fused_inverse_mass &&
+                      Utilities::MPI::min(conforming ? 1 : 0, MPI_COMM_WORLD) == 1;
   }
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim, fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   local_apply_domain(const MatrixFree<dim,value_type>                     &data,
                      LinearAlgebra::distributed::Vector<value_type>       &dst,
                      const LinearAlgebra::distributed::Vector<value_type> &src,
@@ -421,9 +665,9 @@ namespace HDG_WE
 
 
 
-  template <int dim, int fe_degree>
+  template <int dim, int fe_degree, typename Number>
   void
-  WaveEquationOperation<dim,fe_degree>::
+  WaveEquationOperation<dim,fe_degree,Number>::
   evaluate_cell(FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> &phi_v,
                 FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type>   &phi_p,
                 const LinearAlgebra::distributed::Vector<value_type>   &src,
@@ -457,9 +701,9 @@ namespace HDG_WE
 
 
 
-  template <int dim, int fe_degree>
+  template <int dim, int fe_degree, typename Number>
   void
-  WaveEquationOperation<dim,fe_degree>::
+  WaveEquationOperation<dim,fe_degree,Number>::
   local_apply_face (const MatrixFree<dim,value_type> &,
                     LinearAlgebra::distributed::Vector<value_type>       &dst,
                     const LinearAlgebra::distributed::Vector<value_type> &src,
@@ -477,8 +721,8 @@ namespace HDG_WE
 
 
 
-  template <int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::
+  template <int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   evaluate_inner_face(FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
                       FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor,
                       const LinearAlgebra::distributed::Vector<value_type>         &src,
@@ -552,8 +796,8 @@ namespace HDG_WE
 
 
 
-  template <int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::
+  template <int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   local_apply_boundary_face (const MatrixFree<dim,value_type> &,
                              LinearAlgebra::distributed::Vector<value_type>       &dst,
                              const LinearAlgebra::distributed::Vector<value_type> &src,
@@ -566,8 +810,8 @@ namespace HDG_WE
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   evaluate_boundary_face(FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>  &phi,
                          const LinearAlgebra::distributed::Vector<value_type>          &src,
                          const unsigned int                                            face,
@@ -630,54 +874,266 @@ namespace HDG_WE
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim,fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  evaluate_face_by_cell(FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                        FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor,
+                        const LinearAlgebra::distributed::Vector<value_type>         &src,
+                        const unsigned int                                            cell,
+                        const unsigned int                                            face) const
+  {
+    constexpr unsigned int n_vect = VectorizedArray<value_type>::n_array_elements;
+
+    phi.reinit(cell, face);
+    phi.gather_evaluate(src, true, false);
+    const VectorizedArray<value_type> rho_plus = densities[cell];
+    const VectorizedArray<value_type> rho_inv_plus = 1./rho_plus;
+    const VectorizedArray<value_type> c_plus = speeds[cell];
+    const VectorizedArray<value_type> c_sq_plus = c_plus * c_plus;
+    const VectorizedArray<value_type> tau_plus = 1./c_plus/rho_plus;
+
+    // The boundary conditions are imposed through a mirror state in the
+    // exterior: soft wall reflects the velocity, hard wall the pressure and
+    // the absorbing wall sets both to zero. With equal material on both
+    // sides, the inner flux then gives the same lambda as
+    // evaluate_boundary_face.
+    const std::array<types::boundary_id,n_vect> boundary_ids =
+      data.get_faces_by_cells_boundary_id(cell, face);
+    bool has_inner = false, has_boundary = false;
+    value_type mirror_v[n_vect], mirror_p[n_vect];
+    for (unsigned int v=0; v<n_vect; ++v)
+      {
+        mirror_v[v] = 0.;
+        mirror_p[v] = 0.;
+        if (boundary_ids[v] == numbers::internal_face_boundary_id)
+          {
+            has_inner = true;
+            continue;
+          }
+        has_boundary = true;
+        switch (int(boundary_ids[v]))
+          {
+          case 1: // soft wall
+            mirror_v[v] = -1.;
+            mirror_p[v] = 1.;
+            break;
+          case 2: // hard wall
+            mirror_v[v] = 1.;
+            mirror_p[v] = -1.;
+            break;
+          case 3: // absorbing wall
+            break;
+          default:
+            Assert(v >= data.n_components_filled(cell),
+                   ExcMessage("set your boundary ids correctly: 1 - soft wall, 2 - hard wall, 3 - first order ABC"));
+          }
+      }
+
+    if (has_inner)
+      {
+        phi_neighbor.reinit(cell, face);
+        phi_neighbor.gather_evaluate(src, true, false);
+      }
+    const unsigned int face_index = cell*GeometryInfo<dim>::faces_per_cell+face;
+    const VectorizedArray<value_type> rho_minus = face_densities[face_index];
+    const VectorizedArray<value_type> c_minus = face_speeds[face_index];
+    const VectorizedArray<value_type> tau_minus = 1./c_minus/rho_minus;
+
+    const VectorizedArray<value_type> tau_inv = 1./(tau_plus + tau_minus);
+
+    for (unsigned int q=0; q<phi.n_q_points; ++q)
+      {
+        Tensor<1,dim+1,VectorizedArray<value_type> > val_plus = phi.get_value(q);
+        Tensor<1,dim+1,VectorizedArray<value_type> > val_minus;
+        if (has_inner)
+          val_minus = phi_neighbor.get_value(q);
+        if (has_boundary)
+          for (unsigned int v=0; v<n_vect; ++v)
+            if (boundary_ids[v] != numbers::internal_face_boundary_id)
+              {
+                for (unsigned int d=0; d<dim; ++d)
+                  val_minus[d][v] = mirror_v[v]*val_plus[d][v];
+                val_minus[dim][v] = mirror_p[v]*val_plus[dim][v];
+              }
+
+        Tensor<1,dim,VectorizedArray<value_type> > normal = phi.get_normal_vector(q);
+        VectorizedArray<value_type> normal_v_plus = val_plus[0]*normal[0];
+        VectorizedArray<value_type> normal_v_minus = -val_minus[0]*normal[0];
+        for (unsigned int d=1; d<dim; ++d)
+          {
+            normal_v_plus += val_plus[d] * normal[d];
+            normal_v_minus -= val_minus[d] * normal[d];
+          }
+
+        VectorizedArray<value_type> lambda = tau_inv*( normal_v_plus
+                                                       + normal_v_minus
+                                                       + tau_plus * val_plus[dim]
+                                                       + tau_minus * val_minus[dim]);
+        VectorizedArray<value_type> pres_diff_plus = (val_plus[dim]-lambda)*rho_inv_plus;
+        for (unsigned int d=0; d<dim; ++d)
+          val_plus[d] = pres_diff_plus*normal[d];
+        val_plus[dim] = c_sq_plus * rho_plus * (-normal_v_plus + tau_plus * (lambda - val_plus[dim]));
+
+        phi.submit_value(val_plus, q);
+      }
+    phi.integrate(true,false);
+  }
+
+
+
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   local_apply_mass_matrix(const MatrixFree<dim,value_type> &,
                           LinearAlgebra::distributed::Vector<value_type>       &dst,
                           const LinearAlgebra::distributed::Vector<value_type> &src,
                           const std::pair<unsigned int,unsigned int>           &cell_range) const
   {
-#ifdef GAUSS_POINTS_VECTOR_OPERATION
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        mass_matrix_data->get().phi[0].reinit(cell);
+        mass_matrix_data->get().phi[0].read_dof_values(src);
+
+        mass_matrix_data->get().inverse.fill_inverse_JxW_values(mass_matrix_data->get().coefficients);
+        mass_matrix_data->get().apply(mass_matrix_data->get().phi[0].begin_dof_values(),
+                                      mass_matrix_data->get().phi[0].begin_dof_values());
+
+        write_cell_result(mass_matrix_data->get().phi[0], cell, dst);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  write_cell_result(FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                    const unsigned int                                        cell,
+                    LinearAlgebra::distributed::Vector<value_type>           &dst) const
+  {
+    if (stage_update == nullptr)
+      {
+        phi.set_dof_values(dst);
+        return;
+      }
+
+    // the stage derivative k is still in phi, the base vector is read into
+    // the scratch evaluator
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_base = mass_matrix_data->get().phi[1];
+    phi_base.reinit(cell);
+    phi_base.read_dof_values(stage_update->base);
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    const VectorizedArray<value_type> factor1 = make_vectorized_array(stage_update->factor1);
+    const VectorizedArray<value_type> factor2 = make_vectorized_array(stage_update->factor2);
+    VectorizedArray<value_type> *k = phi.begin_dof_values();
+    VectorizedArray<value_type> *base = phi_base.begin_dof_values();
+    if (stage_update->is_last)
+      {
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          k[i] = base[i] + factor1 * k[i];
+        phi.set_dof_values(stage_update->vector1);
+      }
+    else
+      {
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          {
+            base[i] += factor1 * k[i];
+            k[i] = base[i] + factor2 * k[i];
+          }
+        phi_base.set_dof_values(stage_update->vector1);
+        phi.set_dof_values(stage_update->vector2);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  evaluate_cell_and_faces(FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type>       &velocity,
+                          FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type>         &pressure,
+                          FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_face,
+                          FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor,
+                          FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>     &phi,
+                          const LinearAlgebra::distributed::Vector<value_type>         &src,
+                          const unsigned int                                            cell) const
+  {
     constexpr unsigned int dofs_per_component = Utilities::pow(fe_degree+1,dim);
-#endif
+    evaluate_cell(velocity,pressure,src,cell);
+
+    // collect cell and face integrals in the local vector of phi
+    phi.reinit(cell);
+    VectorizedArray<value_type> *local_dofs = phi.begin_dof_values();
+    for (unsigned int i=0; i<dim*dofs_per_component; ++i)
+      local_dofs[i] = velocity.begin_dof_values()[i];
+    for (unsigned int i=0; i<dofs_per_component; ++i)
+      local_dofs[dim*dofs_per_component+i] = pressure.begin_dof_values()[i];
+
+    for (unsigned int face=0; face<GeometryInfo<dim>::faces_per_cell; ++face)
+      {
+        evaluate_face_by_cell(phi_face,phi_neighbor,src,cell,face);
+        for (unsigned int i=0; i<(dim+1)*dofs_per_component; ++i)
+          local_dofs[i] += phi_face.begin_dof_values()[i];
+      }
+  }
+
+
+
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  local_apply_fused(const MatrixFree<dim,value_type>                     &data,
+                    LinearAlgebra::distributed::Vector<value_type>       &dst,
+                    const LinearAlgebra::distributed::Vector<value_type> &src,
+                    const std::pair<unsigned int,unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(data, 0, 0, 0);
+    FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(data, 0, 0, dim);
+    FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_face(data, true, 0, 0, 0);
+    FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_neighbor(data, false, 0, 0, 0);
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = mass_matrix_data->get().phi[0];
+
     for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
       {
-        mass_matrix_data->phi[0].reinit(cell);
-        mass_matrix_data->phi[0].read_dof_values(src);
-
-        mass_matrix_data->inverse.fill_inverse_JxW_values(mass_matrix_data->coefficients);
-#ifdef GAUSS_POINTS_VECTOR_OPERATION
-        for (unsigned int i=0; i<dofs_per_component; ++i)
-          for (unsigned int d=0; d<dim+1; ++d)
-            mass_matrix_data->phi[0].begin_dof_values()[d*dofs_per_component+i] *= mass_matrix_data->coefficients[i];
-#else
-        mass_matrix_data->inverse.apply(mass_matrix_data->coefficients, dim+1,
-                                        mass_matrix_data->phi[0].begin_dof_values(),
-                                        mass_matrix_data->phi[0].begin_dof_values());
-#endif
-
-        mass_matrix_data->phi[0].set_dof_values(dst);
+        evaluate_cell_and_faces(velocity,pressure,phi_face,phi_neighbor,phi,src,cell);
+
+        // all contributions to this cell are present, so the inverse mass
+        // matrix can be applied before writing to dst
+        mass_matrix_data->get().inverse.fill_inverse_JxW_values(mass_matrix_data->get().coefficients);
+        mass_matrix_data->get().apply(phi.begin_dof_values(), phi.begin_dof_values());
+        write_cell_result(phi, cell, dst);
       }
   }
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim, fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   apply(const LinearAlgebra::distributed::Vector<value_type>  &src,
         LinearAlgebra::distributed::Vector<value_type>        &dst) const
   {
     Timer timer;
-    data.loop (&WaveEquationOperation<dim, fe_degree>::local_apply_domain,
-               &WaveEquationOperation<dim, fe_degree>::local_apply_face,
-               &WaveEquationOperation<dim, fe_degree>::local_apply_boundary_face,
-               this, dst, src, true,
-               MatrixFree<dim,value_type>::DataAccessOnFaces::values,
-               MatrixFree<dim,value_type>::DataAccessOnFaces::values);
+    if (use_fused_apply)
+      {
+        // neighbor data is read by the cell batches, so cell_loop exchanges
+        // all ghosts before the first cell and nothing is overlapped, see the
+        // check of overlap_communication in Parameters
+        data.cell_loop(&WaveEquationOperation<dim,fe_degree,Number>::local_apply_fused,
+                       this, dst, src);
+        computing_times[0] += timer.wall_time();
+        computing_times[2] += 1.;
+        return;
+      }
+
+    timed_loop([&]()
+    {
+      data.loop (&WaveEquationOperation<dim,fe_degree,Number>::local_apply_domain,
+                 &WaveEquationOperation<dim,fe_degree,Number>::local_apply_face,
+                 &WaveEquationOperation<dim,fe_degree,Number>::local_apply_boundary_face,
+                 this, dst, src, true,
+                 MatrixFree<dim,value_type>::DataAccessOnFaces::values,
+                 MatrixFree<dim,value_type>::DataAccessOnFaces::values);
+    }, src, 0);
     computing_times[0] += timer.wall_time();
 
     timer.restart();
-    data.cell_loop(&WaveEquationOperation<dim, fe_degree>::local_apply_mass_matrix,
+    data.cell_loop(&WaveEquationOperation<dim,fe_degree,Number>::local_apply_mass_matrix,
                    this, dst, dst);
     computing_times[1] += timer.wall_time();
 
@@ -686,29 +1142,40 @@ namespace HDG_WE
 
 
 
+  template<int dim, int fe_degree, typename Number>
+  bool WaveEquationOperation<dim,fe_degree,Number>::
+  apply_and_update(const LinearAlgebra::distributed::Vector<value_type>                                  &src,
+                   LinearAlgebra::distributed::Vector<value_type>                                        &dst,
+                   const LowStorageRKStageUpdate<LinearAlgebra::distributed::Vector<value_type> > &update) const
+  {
+    stage_update = &update;
+    WaveEquationOperation<dim,fe_degree,Number>::apply(src, dst);
+    stage_update = nullptr;
+    return true;
+  }
+
+
+
   template<int dim, int fe_degree>
   void WaveEquationOperationADERADCONFULL<dim, fe_degree>::
   apply_ader(const LinearAlgebra::distributed::Vector<value_type>  &src,
              LinearAlgebra::distributed::Vector<value_type>        &dst) const
   {
-    LinearAlgebra::distributed::Vector<value_type> tempvals;
-    tempvals.reinit(dst);
-    this->tempsrc=0;
-
     double dt = this->time_control.get_time_step();
 
-    // k=0 contribution
+    // k=0 contribution, which initializes the sum in dst
     //{
     this->data.loop (&WaveEquationOperation<dim, fe_degree>::local_apply_domain,
                      &WaveEquationOperation<dim, fe_degree>::local_apply_face,
                      &WaveEquationOperation<dim, fe_degree>::local_apply_boundary_face,
-                     static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), dst, src,
+                     static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), tempsrc, src,
                      true, MatrixFree<dim,value_type>::DataAccessOnFaces::values,
                      MatrixFree<dim,value_type>::DataAccessOnFaces::values);
-    this->data.cell_loop(&WaveEquationOperation<dim, fe_degree>::local_apply_mass_matrix,
-                         static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), dst, dst);
-    this->tempsrc.sadd(1.0,-dt,dst);
-    tempvals.equ(-1.,dst);
+    taylor_factor = dt;
+    first_taylor_term = true;
+    this->data.cell_loop(&WaveEquationOperationADERADCONFULL<dim, fe_degree>::local_apply_mass_matrix_taylor,
+                         this, dst, tempsrc);
+    first_taylor_term = false;
     //}
 
     // all remaining contributions
@@ -718,20 +1185,56 @@ namespace HDG_WE
         this->data.loop (&WaveEquationOperation<dim, fe_degree>::local_apply_domain,
                          &WaveEquationOperation<dim, fe_degree>::local_apply_face,
                          &WaveEquationOperation<dim, fe_degree>::local_apply_boundary_face,
-                         static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), dst, tempvals,
+                         static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), tempsrc, tempvals,
                          true, MatrixFree<dim,value_type>::DataAccessOnFaces::values,
                          MatrixFree<dim,value_type>::DataAccessOnFaces::values);
-        this->data.cell_loop(&WaveEquationOperation<dim, fe_degree>::local_apply_mass_matrix,
-                             static_cast<const WaveEquationOperation<dim,fe_degree>*>(this), dst, dst);
-
-        this->tempsrc.sadd(1.0,-fac,dst);
-        tempvals.equ(-1.,dst);
-        dst = 0.;
+        taylor_factor = fac;
+        this->data.cell_loop(&WaveEquationOperationADERADCONFULL<dim, fe_degree>::local_apply_mass_matrix_taylor,
+                             this, dst, tempsrc);
 
         fac *= -dt/(k+2);
       }
+  }
+
+
 
-    dst = this->tempsrc;
+  template<int dim, int fe_degree>
+  void WaveEquationOperationADERADCONFULL<dim, fe_degree>::
+  local_apply_mass_matrix_taylor(const MatrixFree<dim,value_type> &,
+                                 LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                 const LinearAlgebra::distributed::Vector<value_type> &src,
+                                 const std::pair<unsigned int,unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[0];
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_sum = this->mass_matrix_data->get().phi[1];
+    const VectorizedArray<value_type> factor = make_vectorized_array(taylor_factor);
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+
+    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+      {
+        phi.reinit(cell);
+        phi.read_dof_values(src);
+        this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
+        this->mass_matrix_data->get().apply(phi.begin_dof_values(), phi.begin_dof_values());
+
+        VectorizedArray<value_type> *derivative = phi.begin_dof_values();
+        VectorizedArray<value_type> *sum = phi_sum.begin_dof_values();
+        phi_sum.reinit(cell);
+        if (first_taylor_term)
+          for (unsigned int i=0; i<dofs_per_cell; ++i)
+            sum[i] = -factor * derivative[i];
+        else
+          {
+            phi_sum.read_dof_values(dst);
+            for (unsigned int i=0; i<dofs_per_cell; ++i)
+              sum[i] -= factor * derivative[i];
+          }
+        phi_sum.set_dof_values(dst);
+
+        for (unsigned int i=0; i<dofs_per_cell; ++i)
+          derivative[i] = -derivative[i];
+        phi.set_dof_values(tempvals);
+      }
   }
 
 
@@ -781,13 +1284,13 @@ namespace HDG_WE
   }
 
 
-  template <int dim, int fe_degree>
-  void WaveEquationOperation<dim, fe_degree>::
+  template <int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   compute_post_pressure(const LinearAlgebra::distributed::Vector<value_type> &solution,
                         LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
                         LinearAlgebra::distributed::Vector<value_type>            &post_pressure_vector) const
   {
-    WaveEquationOperation<dim,fe_degree>::apply(solution, tmp_vector);
+    WaveEquationOperation<dim,fe_degree,Number>::apply(solution, tmp_vector);
 
     FEEvaluation<dim,fe_degree,fe_degree+2,dim,value_type> velocity(data, 0, 1, 0);
     FEEvaluation<dim,fe_degree,fe_degree+2,1,value_type> pressure(data, 0, 1, dim);
@@ -868,13 +1371,13 @@ namespace HDG_WE
 
 
 
-  template <int dim, int fe_degree>
-  void WaveEquationOperation<dim, fe_degree>::
+  template <int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   estimate_error(const LinearAlgebra::distributed::Vector<value_type> &solution,
                  LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
                  Vector<double>                                       &post_pressure_vector) const
   {
-    WaveEquationOperation<dim,fe_degree>::apply(solution, tmp_vector);
+    WaveEquationOperation<dim,fe_degree,Number>::apply(solution, tmp_vector);
 
     FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(data, 0, 0, 0);
     FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(data, 0, 0, dim);
@@ -899,39 +1402,162 @@ namespace HDG_WE
 
 
 
-  template<int dim, int fe_degree>
-  void WaveEquationOperation<dim, fe_degree>::
+  template<int dim, int fe_degree, typename Number>
+  template <typename FunctorType>
+  void WaveEquationOperation<dim,fe_degree,Number>::
+  project_function(LinearAlgebra::distributed::Vector<value_type> &solution,
+                   const FunctorType                              &evaluate) const
+  {
+    const std::function<void (const MatrixFree<dim,value_type> &,
+                              LinearAlgebra::distributed::Vector<value_type> &,
+                              const unsigned int &,
+                              const std::pair<unsigned int,unsigned int> &)>
+    local_project = [&](const MatrixFree<dim,value_type> &,
+                        LinearAlgebra::distributed::Vector<value_type> &dst,
+                        const unsigned int &,
+                        const std::pair<unsigned int,unsigned int> &cell_range)
+    {
+      const unsigned int n_q_points = FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>::static_n_q_points;
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = mass_matrix_data->get().phi[0];
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          phi.reinit(cell);
+          for (unsigned int q=0; q<n_q_points; ++q)
+            phi.submit_value(evaluate(phi.quadrature_point(q)),q);
+          phi.integrate(true,false);
+
+          mass_matrix_data->get().inverse.fill_inverse_JxW_values(mass_matrix_data->get().coefficients);
+          mass_matrix_data->get().apply(phi.begin_dof_values(),
+                                        phi.begin_dof_values());
+          phi.set_dof_values(dst);
+        }
+    };
+
+    // every owned entry is written, the loop only adds the zero ghosts
+    solution.zero_out_ghosts();
+    const unsigned int dummy = 0;
+    data.cell_loop(local_project, solution, dummy);
+  }
+
+
+
+  template<int dim, int fe_degree, typename Number>
+  void WaveEquationOperation<dim,fe_degree,Number>::
   project_initial_field(LinearAlgebra::distributed::Vector<value_type> &solution,
                         const Function<dim>                            &function) const
   {
-    const unsigned int n_q_points = FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>::static_n_q_points;
-    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = mass_matrix_data->phi[0];
-
-    for (unsigned int cell=0; cell<data.n_macro_cells(); ++cell)
+    // the exact solution is evaluated on all lanes of a batch at once, other
+    // functions point by point through the virtual interface
+    const ExactSolution<dim> *exact_solution = dynamic_cast<const ExactSolution<dim> *>(&function);
+    if (exact_solution != nullptr)
+      project_function(solution, [&](const Point<dim,VectorizedArray<value_type> > &p)
       {
-        phi.reinit(cell);
-        for (unsigned int q=0; q<n_q_points; ++q)
+        Tensor<1,dim+1,VectorizedArray<value_type> > values;
+        for (unsigned int d=0; d<dim+1; ++d)
+          values[d] = exact_solution->value(p,d);
+        return values;
+      });
+    else
+      project_function(solution, [&](const Point<dim,VectorizedArray<value_type> > &p)
+      {
+        Tensor<1,dim+1,VectorizedArray<value_type> > values;
+        for (unsigned int v=0; v<VectorizedArray<value_type>::n_array_elements; ++v)
           {
-            Point<dim,VectorizedArray<value_type> > q_points = phi.quadrature_point(q);
-            Tensor<1,dim+1,VectorizedArray<value_type> > rhs;
+            Point<dim> q_point;
+            for (unsigned int e=0; e<dim; ++e)
+              q_point[e] = p[e][v];
             for (unsigned int d=0; d<dim+1; ++d)
-              for (unsigned int v=0; v<VectorizedArray<value_type>::n_array_elements; ++v)
-                {
-                  Point<dim> q_point;
-                  for (unsigned int e=0; e<dim; ++e)
-                    q_point[e] = q_points[e][v];
-                  rhs[d][v] = function.value(q_point,d);
-                }
-            phi.submit_value(rhs,q);
+              values[d][v] = function.value(q_point,d);
           }
-        phi.integrate(true,false);
+        return values;
+      });
+  }
 
-        mass_matrix_data->inverse.fill_inverse_JxW_values(mass_matrix_data->coefficients);
-        mass_matrix_data->inverse.apply(mass_matrix_data->coefficients, dim+1,
-                                        phi.begin_dof_values(),
-                                        phi.begin_dof_values());
-        phi.set_dof_values(solution);
-      }
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationADER<dim, fe_degree>::
+  apply_ader_task_graph(const LinearAlgebra::distributed::Vector<value_type>  &src,
+                        LinearAlgebra::distributed::Vector<value_type>        &dst) const
+  {
+    const unsigned int n_batches = this->data.n_macro_cells();
+    for (unsigned int b=0; b<n_batches; ++b)
+      pending_dependencies[b] = n_dependencies[b];
+
+    // corrector of one cell batch: cell and face integrals of the predicted
+    // solution seen from the cell, followed by the inverse mass matrix. The
+    // sign is flipped with respect to apply() to match the face loop path.
+    const auto correct = [&](const unsigned int cell,
+                             FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type>       &velocity,
+                             FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type>         &pressure,
+                             FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_face,
+                             FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_neighbor)
+    {
+      constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[0];
+      this->evaluate_cell_and_faces(velocity,pressure,phi_face,phi_neighbor,phi,tempsrc,cell);
+      this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
+      this->mass_matrix_data->get().apply(phi.begin_dof_values(), phi.begin_dof_values());
+      for (unsigned int i=0; i<dofs_per_cell; ++i)
+        phi.begin_dof_values()[i] = -phi.begin_dof_values()[i];
+      phi.set_dof_values(dst);
+    };
+
+    // predictor of a range of batch_order, each batch that has all its
+    // dependencies predicted is corrected right away by the same thread
+    // while the predicted data is still in cache. With post-processing, the
+    // derivative of src the predictor reads is computed on the same batch
+    // just before, instead of in a separate operator evaluation.
+    const auto predict = [&](const unsigned int begin, const unsigned int end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(this->data, 0, 0, 0);
+      FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(this->data, 0, 0, dim);
+      FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_face(this->data, true, 0, 0, 0);
+      FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_neighbor(this->data, false, 0, 0, 0);
+      for (unsigned int i=begin; i<end; ++i)
+        {
+          const unsigned int cell = batch_order[i];
+          FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->get().phi[0];
+          if (this->parameters.use_ader_post)
+            {
+              this->evaluate_cell_and_faces(velocity,pressure,phi_face,phi_neighbor,phi_eval,src,cell);
+              this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
+              this->mass_matrix_data->get().apply(phi_eval.begin_dof_values(), phi_eval.begin_dof_values());
+              phi_eval.set_dof_values(tempsrc);
+            }
+          integrate_taylor_cauchykovalewski(cell,phi_eval,src,this->time_control.get_time_step(),0.0,0.0,tempsrc);
+          phi_eval.set_dof_values(tempsrc);
+          for (unsigned int j=0; j<dependent_batches[cell].size(); ++j)
+            if (pending_dependencies[dependent_batches[cell][j]].fetch_sub(1) == 1)
+              correct(dependent_batches[cell][j],velocity,pressure,phi_face,phi_neighbor);
+        }
+    };
+
+    // the batches with ghost neighbors are predicted first and sent while
+    // the interior batches run through predictor and corrector
+    const unsigned int n_ghost_neighbor_batches = ghost_neighbor_batches.size();
+    if (this->parameters.use_ader_post)
+      src.update_ghost_values();
+    parallel::apply_to_subranges(0U, n_ghost_neighbor_batches, predict, this->cell_grain_size);
+    tempsrc.update_ghost_values_start();
+    parallel::apply_to_subranges(n_ghost_neighbor_batches, n_batches, predict, this->cell_grain_size);
+    tempsrc.update_ghost_values_finish();
+
+    parallel::apply_to_subranges(0U, n_ghost_neighbor_batches,
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(this->data, 0, 0, 0);
+      FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(this->data, 0, 0, dim);
+      FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_face(this->data, true, 0, 0, 0);
+      FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_neighbor(this->data, false, 0, 0, 0);
+      for (unsigned int i=begin; i<end; ++i)
+        if (pending_dependencies[ghost_neighbor_batches[i]].fetch_sub(1) == 1)
+          correct(ghost_neighbor_batches[i],velocity,pressure,phi_face,phi_neighbor);
+    }, this->cell_grain_size);
+    tempsrc.zero_out_ghosts();
+    if (this->parameters.use_ader_post)
+      src.zero_out_ghosts();
   }
 
 
@@ -945,7 +1571,7 @@ namespace HDG_WE
   {
     // for calculation of higher spatial derivatives
     //{
-    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->phi[0];
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->get().phi[0];
     //}
 
     // cell loop
@@ -1044,7 +1670,7 @@ namespace HDG_WE
           }
       }
 
-    this->mass_matrix_data->inverse.fill_inverse_JxW_values(this->mass_matrix_data->coefficients);
+    this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
 
     // all following contributions can be looped
     integrate_taylor_cauchykovalewski_step<0,true>(cell, phi_eval, phi_eval.begin_values(),
@@ -1054,8 +1680,8 @@ namespace HDG_WE
     // phi_eval.submit_value();
     // phi_eval.integrate();
     // inverse.apply();
-    this->mass_matrix_data->inverse.
-    transform_from_q_points_to_basis(dim+1, contrib, phi_eval.begin_dof_values());
+    this->mass_matrix_data->get().
+    transform_from_q_points_to_basis(contrib, phi_eval.begin_dof_values());
   }
 
 
@@ -1203,9 +1829,8 @@ namespace HDG_WE
 
         // apply inverse mass matrix
         //{
-        this->mass_matrix_data->inverse.apply(this->mass_matrix_data->coefficients, dim+1,
-                                              phi_eval.begin_dof_values(),
-                                              phi_eval.begin_dof_values());
+        this->mass_matrix_data->get().apply(phi_eval.begin_dof_values(),
+                                            phi_eval.begin_dof_values());
         //}
 
         // evaulate this phi at the gauss points
@@ -1350,6 +1975,14 @@ namespace HDG_WE
   {
 
     Timer timer;
+    if (this->use_fused_apply)
+      {
+        // computes the post-processing derivative within the predictor
+        apply_ader_task_graph(src, dst);
+        this->computing_times[5] += timer.wall_time();
+        return;
+      }
+
     if (this->parameters.use_ader_post)
       WaveEquationOperation<dim,fe_degree>::apply(src,tempsrc);
     this->computing_times[3] += timer.wall_time();
@@ -1360,12 +1993,15 @@ namespace HDG_WE
                           this, tempsrc, src);
     this->computing_times[4] += timer.wall_time();
     timer.restart();
-    this->data.loop (&WaveEquationOperationADER<dim, fe_degree>::local_apply_secondader_domain,
-                     &WaveEquationOperationADER<dim, fe_degree>::local_apply_ader_face,
-                     &WaveEquationOperationADER<dim, fe_degree>::local_apply_ader_boundary_face,
-                     this, dst, tempsrc, true,
-                     MatrixFree<dim,value_type>::DataAccessOnFaces::values,
-                     MatrixFree<dim,value_type>::DataAccessOnFaces::values);
+    this->timed_loop([&]()
+    {
+      this->data.loop (&WaveEquationOperationADER<dim, fe_degree>::local_apply_secondader_domain,
+                       &WaveEquationOperationADER<dim, fe_degree>::local_apply_ader_face,
+                       &WaveEquationOperationADER<dim, fe_degree>::local_apply_ader_boundary_face,
+                       this, dst, tempsrc, true,
+                       MatrixFree<dim,value_type>::DataAccessOnFaces::values,
+                       MatrixFree<dim,value_type>::DataAccessOnFaces::values);
+    }, tempsrc, 1);
     this->computing_times[5] += timer.wall_time();
 
     // inverse mass matrix
@@ -1389,124 +2025,131 @@ namespace HDG_WE
                                const LinearAlgebra::distributed::Vector<value_type>   &src,
                                const std::pair<unsigned int,unsigned int>                 &cell_range) const
   {
-    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->phi[0];
-
-    // cell loop
-    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
-      {
-        if (cluster_manager.is_evaluate_cell(cell))
-          {
-            value_type t1 = cluster_manager.get_t1();
-            value_type t2 = cluster_manager.get_t2();
-            value_type te = cluster_manager.get_te(cell);
-
-            this->integrate_taylor_cauchykovalewski(cell,phi_eval,src,t2,t1,te,cluster_manager.improvedgraddiv);
-            phi_eval.set_dof_values(dst);
-          }
-      } // for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
-  }
+    // loop over the cells flagged by the cluster manager, distributed over
+    // the threads with their own scratch data
+    const std::vector<unsigned int> &cells = cluster_manager.get_evaluate_cells();
+    parallel::apply_to_subranges(0U, static_cast<unsigned int>(cells.size()),
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->get().phi[0];
+      for (unsigned int i=begin; i<end; ++i)
+        {
+          const unsigned int cell = cells[i];
+          if (cell<cell_range.first || cell>=cell_range.second)
+            continue;
+
+          value_type t1 = cluster_manager.get_t1();
+          value_type t2 = cluster_manager.get_t2();
+          value_type te = cluster_manager.get_te(cell);
+
+          this->integrate_taylor_cauchykovalewski(cell,phi_eval,src,t2,t1,te,cluster_manager.improvedgraddiv);
+          phi_eval.set_dof_values(dst);
+        }
+    }, this->cell_grain_size);
+
+    for (unsigned int i=0; i<cells.size(); ++i)
+      if (cells[i]>=cell_range.first && cells[i]<cell_range.second)
+        tempsrc_cells.push_back(cells[i]);
+  }
 
 
 
   template<int dim, int fe_degree>
   void WaveEquationOperationADERLTS<dim,fe_degree>::
-  local_apply_secondader_domain(const MatrixFree<dim,value_type> &,
-                                LinearAlgebra::distributed::Vector<value_type>         &dst,
-                                const LinearAlgebra::distributed::Vector<value_type>   &src,
-                                const std::pair<unsigned int,unsigned int>             &cell_range) const
+  local_apply_secondader_update(LinearAlgebra::distributed::Vector<value_type>  &state,
+                                LinearAlgebra::distributed::Vector<value_type>  &face_contributions,
+                                const std::pair<unsigned int,unsigned int>      &cell_range) const
   {
-    // for calculation of higher spatial derivatives
-    //{
     const unsigned int n_q_points = FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type>::static_n_q_points;
-    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->phi[0];
-    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> help_eval(this->data); // for memory variable and update of src
-    //}
 
-    // cell loop
-    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
-      {
-        if (cluster_manager.is_update_cell(cell))
-          {
-            value_type dt = cluster_manager.get_dt();
-            this->integrate_taylor_cauchykovalewski(cell,phi_eval,src,dt,0.,0.,cluster_manager.improvedgraddiv);
+    // the cells flagged by the cluster manager are independent of each other,
+    // so distribute them over the threads with their own scratch data
+    const std::vector<unsigned int> &cells = cluster_manager.get_update_cells();
+    parallel::apply_to_subranges(0U, static_cast<unsigned int>(cells.size()),
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_eval = this->mass_matrix_data->get().phi[0];
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> help_eval(this->data); // for memory variable and update of src
 
-            // the standard business analog to local_apply_firstaderlts is done
-            // now comes the update!
+      for (unsigned int i=begin; i<end; ++i)
+        {
+          const unsigned int cell = cells[i];
+          if (cell>=cell_range.first && cell<cell_range.second)
             {
-              phi_eval.evaluate (true, true, false);
+              value_type dt = cluster_manager.get_dt();
+              this->integrate_taylor_cauchykovalewski(cell,phi_eval,state,dt,0.,0.,cluster_manager.improvedgraddiv);
 
-              const VectorizedArray<value_type> rho = this->densities[cell];
-              const VectorizedArray<value_type> rho_inv = 1./this->densities[cell];
-              const VectorizedArray<value_type> c_sq = this->speeds[cell]*this->speeds[cell];
+              // the standard business analog to local_apply_firstaderlts is done
+              // now comes the update!
+              {
+                phi_eval.evaluate (true, true, false);
 
-              for (unsigned int q=0; q<n_q_points; ++q)
-                {
-                  const Tensor<1,dim+1,Tensor<1,dim,VectorizedArray<value_type> > > v_and_p_grad = phi_eval.get_gradient(q);
-                  const Tensor<1,dim+1,VectorizedArray<value_type> > v_and_p = phi_eval.get_value(q);
+                const VectorizedArray<value_type> rho = this->densities[cell];
+                const VectorizedArray<value_type> rho_inv = 1./this->densities[cell];
+                const VectorizedArray<value_type> c_sq = this->speeds[cell]*this->speeds[cell];
+
+                for (unsigned int q=0; q<n_q_points; ++q)
+                  {
+                    const Tensor<1,dim+1,Tensor<1,dim,VectorizedArray<value_type> > > v_and_p_grad = phi_eval.get_gradient(q);
+                    const Tensor<1,dim+1,VectorizedArray<value_type> > v_and_p = phi_eval.get_value(q);
 
-                  Tensor<1,dim+1,VectorizedArray<value_type> > temp_value;
-                  for (unsigned int d=0; d<dim; ++d)
-                         temp_value[d] = rho_inv*v_and_p_grad[dim][d];
-                  phi_eval.submit_value(temp_value,q);
+                    Tensor<1,dim+1,VectorizedArray<value_type> > temp_value;
+                    for (unsigned int d=0; d<dim; ++d)
+                           temp_value[d] = rho_inv*v_and_p_grad[dim][d];
+                    phi_eval.submit_value(temp_value,q);
 
-                  Tensor<1,dim+1,Tensor<1,dim,VectorizedArray<value_type> > > temp_gradient;
-                  for (unsigned int d=0; d<dim; ++d)
-                         temp_gradient[dim][d] = -rho*c_sq*v_and_p[d];
+                    Tensor<1,dim+1,Tensor<1,dim,VectorizedArray<value_type> > > temp_gradient;
+                    for (unsigned int d=0; d<dim; ++d)
+                           temp_gradient[dim][d] = -rho*c_sq*v_and_p[d];
 
-                  phi_eval.submit_gradient(temp_gradient,q);
-                }
+                    phi_eval.submit_gradient(temp_gradient,q);
+                  }
 
-              phi_eval.integrate (true, true);
+                phi_eval.integrate (true, true);
 
-              // add memory variable
-              unsigned int dofs_per_cell = phi_eval.dofs_per_cell;
-              help_eval.reinit(cell);
-              if (cluster_manager.is_fluxmemory_considered)
-                {
-                  help_eval.read_dof_values(flux_memory);
-                  for (unsigned j=0; j<dofs_per_cell; ++j)
-                         for (unsigned int d=0; d<dim+1; ++d)
+                // add memory variable
+                unsigned int dofs_per_cell = phi_eval.dofs_per_cell;
+                help_eval.reinit(cell);
+                const unsigned int flux_memory_index = cluster_manager.get_flux_memory_index(cell);
+                if (cluster_manager.is_fluxmemory_considered && flux_memory_index!=numbers::invalid_unsigned_int)
+                  {
+                    VectorizedArray<value_type> *memory = &flux_memory[flux_memory_index*(dim+1)*dofs_per_cell];
+                    for (unsigned j=0; j<(dim+1)*dofs_per_cell; ++j)
                       {
-                        phi_eval.begin_dof_values()[d*dofs_per_cell+j] += help_eval.begin_dof_values()[d*dofs_per_cell+j];
-                        help_eval.begin_dof_values()[d*dofs_per_cell+j] = 0.;
+                        phi_eval.begin_dof_values()[j] += memory[j];
+                        memory[j] = 0.;
                       }
-                  help_eval.set_dof_values(flux_memory); // tell the flux_memory variable, that some of its values are reset
-                }
-
-              // add face contribution (stored in dst) and reset dst to zero
-              help_eval.read_dof_values(dst, 0);
-              for (unsigned j=0; j<dofs_per_cell; ++j)
-                     for (unsigned int d=0; d<dim+1; ++d)
-                  {
-                    phi_eval.begin_dof_values()[d*dofs_per_cell+j] += help_eval.begin_dof_values()[d*dofs_per_cell+j];
-                    help_eval.begin_dof_values()[d*dofs_per_cell+j] = 0.;
                   }
-              help_eval.set_dof_values(dst);
 
-              // apply inverse mass matrix
-              this->mass_matrix_data->inverse.apply(this->mass_matrix_data->coefficients, dim+1,
-                                                    phi_eval.begin_dof_values(),
+                // add face contribution and reset it to zero
+                help_eval.read_dof_values(face_contributions, 0);
+                for (unsigned j=0; j<dofs_per_cell; ++j)
+                       for (unsigned int d=0; d<dim+1; ++d)
+                    {
+                      phi_eval.begin_dof_values()[d*dofs_per_cell+j] += help_eval.begin_dof_values()[d*dofs_per_cell+j];
+                      help_eval.begin_dof_values()[d*dofs_per_cell+j] = 0.;
+                    }
+                help_eval.set_dof_values(face_contributions);
+
+                // apply inverse mass matrix
+                this->mass_matrix_data->get().apply(phi_eval.begin_dof_values(),
                                                     phi_eval.begin_dof_values());
-              //}
-              phi_eval.set_dof_values(dst);
+                //}
+
+                // update the state of this cell in place
+                help_eval.read_dof_values(state);
+                for (unsigned j=0; j<dofs_per_cell; ++j)
+                       for (unsigned int d=0; d<dim+1; ++d)
+                    help_eval.begin_dof_values()[d*dofs_per_cell+j] -= phi_eval.begin_dof_values()[d*dofs_per_cell+j];
+                help_eval.set_dof_values(state);
+              }
             }
-          }
-      } // for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        }
+    }, this->cell_grain_size);
   }
 
 
 
-  // does nothing
-  template<int dim, int fe_degree>
-  void WaveEquationOperationADERLTS<dim,fe_degree>::
-  local_apply_dummy_domain(const MatrixFree<dim,value_type> &,
-                           LinearAlgebra::distributed::Vector<value_type> &,
-                           const LinearAlgebra::distributed::Vector<value_type> &,
-                           const std::pair<unsigned int,unsigned int> &) const
-  {}
-
-
-
   template <int dim, int fe_degree>
   void
   WaveEquationOperationADERLTS<dim,fe_degree>::
@@ -1529,13 +2172,37 @@ namespace HDG_WE
 
             // get bitsets from cluster manager
             phi.distribute_local_to_global(dst, 0, cluster_manager.get_phi_to_dst(face));
-            phi.distribute_local_to_global(flux_memory, 0, cluster_manager.get_phi_to_fluxmemory(face));
             phi_neighbor.distribute_local_to_global(dst, 0, cluster_manager.get_phi_neighbor_to_dst(face));
-            phi_neighbor.distribute_local_to_global(flux_memory, 0, cluster_manager.get_phi_neighbor_to_fluxmemory(face));
+            const std::bitset<n_vect> phi_to_fluxmemory = cluster_manager.get_phi_to_fluxmemory(face);
+            const std::bitset<n_vect> phi_neighbor_to_fluxmemory = cluster_manager.get_phi_neighbor_to_fluxmemory(face);
+            const internal::MatrixFreeFunctions::FaceToCellTopology<n_vect> &face_info = this->data.get_face_info(face);
+            for (unsigned int v=0; v<n_vect; ++v)
+              {
+                if (phi_to_fluxmemory[v])
+                  add_to_flux_memory(phi, v, face_info.cells_interior[v]);
+                if (phi_neighbor_to_fluxmemory[v])
+                  add_to_flux_memory(phi_neighbor, v, face_info.cells_exterior[v]);
+              }
           }
       }
   }
 
+  template <int dim, int fe_degree>
+  void WaveEquationOperationADERLTS<dim,fe_degree>::
+  add_to_flux_memory(const FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi,
+                     const unsigned int                                                  lane,
+                     const unsigned int                                                  cell) const
+  {
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    const unsigned int flux_memory_index = cluster_manager.get_flux_memory_index(cell/n_vect);
+    Assert(flux_memory_index!=numbers::invalid_unsigned_int,
+           ExcMessage("flux memory written to a cell away from the cluster interfaces"));
+    VectorizedArray<value_type> *memory = &flux_memory[flux_memory_index*dofs_per_cell];
+    const VectorizedArray<value_type> *values = phi.begin_dof_values();
+    for (unsigned int j=0; j<dofs_per_cell; ++j)
+      memory[j][cell%n_vect] += values[j][lane];
+  }
+
   template <int dim, int fe_degree>
   void WaveEquationOperationADERLTS<dim,fe_degree>::
   local_apply_ader_boundary_face (const MatrixFree<dim,value_type> &,
@@ -1562,24 +2229,102 @@ namespace HDG_WE
     const LinearAlgebra::distributed::Vector<value_type>  &src,
     LinearAlgebra::distributed::Vector<value_type>        &dst) const
   {
-    this->data.cell_loop (&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_firstader_domain,
-                          this, this->tempsrc, src, true);
+    // the cell part only touches locally owned cells, so we call it directly
+    // on the flagged cells. Instead of zeroing all of tempsrc, reset the
+    // cells written in the previous call.
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_zero = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    for (unsigned int i=0; i<tempsrc_cells.size(); ++i)
+      {
+        phi_zero.reinit(tempsrc_cells[i]);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          phi_zero.begin_dof_values()[j] = 0.;
+        phi_zero.set_dof_values(this->tempsrc);
+      }
+    tempsrc_cells.clear();
+
+    local_apply_firstader_domain(this->data, this->tempsrc, src,
+                                 std::make_pair(0U,this->data.n_macro_cells()));
+
+    // evaluate faces for these cells, only the face range of the current
+    // cluster can contain flagged faces. The restricted exchange of
+    // face_range_loop is not overlapped, so no communication statistics are
+    // sampled here
+    face_range_loop(&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_ader_face,
+                    &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_ader_boundary_face,
+                    dst, this->tempsrc);
+  }
+
 
-    // evaluate faces for these cells
-    this->data.loop (&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_dummy_domain,
-                     &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_ader_face,
-                     &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_ader_boundary_face,
-                     this, dst, this->tempsrc);
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationADERLTS<dim,fe_degree>::
+  face_range_loop(const face_worker                                     inner_face_worker,
+                  const face_worker                                     boundary_face_worker,
+                  LinearAlgebra::distributed::Vector<value_type>       &dst,
+                  const LinearAlgebra::distributed::Vector<value_type> &src) const
+  {
+    // data exchange of MatrixFree::loop, restricted to the ghost cells of the
+    // clusters next to the evaluated one
+    const bool ghosts_set = src.has_ghost_elements();
+    if (!ghosts_set)
+      cluster_manager.update_ghost_values(src);
+
+    (this->*inner_face_worker)(this->data, dst, src, cluster_manager.get_inner_face_range());
+    (this->*boundary_face_worker)(this->data, dst, src, cluster_manager.get_boundary_face_range());
+
+    if (!ghosts_set)
+      src.zero_out_ghosts();
+    cluster_manager.compress_add(dst);
   }
 
 
   template<int dim, int fe_degree>
   void WaveEquationOperationADERLTS<dim,fe_degree>::evaluate_cells_second_ader(
-    const LinearAlgebra::distributed::Vector<value_type>  &src,
-    LinearAlgebra::distributed::Vector<value_type>        &dst) const
+    LinearAlgebra::distributed::Vector<value_type>  &state,
+    LinearAlgebra::distributed::Vector<value_type>  &face_contributions) const
+  {
+    local_apply_secondader_update(state, face_contributions,
+                                  std::make_pair(0U,this->data.n_macro_cells()));
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationADERLTS<dim,fe_degree>::
+  copy_cells_to_buffer(const std::vector<unsigned int>                          &cells,
+                       const LinearAlgebra::distributed::Vector<value_type>     &src,
+                       AlignedVector<VectorizedArray<value_type> >              &buffer) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        phi.reinit(cells[i]);
+        phi.read_dof_values(src);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          buffer.push_back(phi.begin_dof_values()[j]);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationADERLTS<dim,fe_degree>::
+  copy_buffer_to_cells(const std::vector<unsigned int>                          &cells,
+                       const AlignedVector<VectorizedArray<value_type> >        &buffer,
+                       LinearAlgebra::distributed::Vector<value_type>           &dst) const
   {
-    this->data.cell_loop (&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_secondader_domain,
-                          this, dst, src);
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    AssertDimension(buffer.size(), cells.size()*dofs_per_cell);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        phi.reinit(cells[i]);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          phi.begin_dof_values()[j] = buffer[i*dofs_per_cell+j];
+        phi.set_dof_values(dst);
+      }
   }
 
   template<int dim, int fe_degree>
@@ -1594,13 +2339,14 @@ namespace HDG_WE
   void WaveEquationOperationADERLTS<dim,fe_degree>::reconstruct_div_grad(const LinearAlgebra::distributed::Vector<value_type>  &src,
       LinearAlgebra::distributed::Vector<value_type>        &dst) const
   {
-    this->data.loop (&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_domain,
-                     &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_face,
-                     &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_boundary_face,
-                     this, dst, src);
-
-    this->data.cell_loop(&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_mass_matrix,
-                         this, dst, dst);
+    local_apply_postprocessing_domain(this->data, dst, src,
+                                      std::make_pair(0U,this->data.n_macro_cells()));
+    face_range_loop(&WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_face,
+                    &WaveEquationOperationADERLTS<dim, fe_degree>::local_apply_postprocessing_boundary_face,
+                    dst, src);
+
+    local_apply_postprocessing_mass_matrix(this->data, dst, dst,
+                                           std::make_pair(0U,this->data.n_macro_cells()));
   }
 
   template<int dim, int fe_degree>
@@ -1613,9 +2359,11 @@ namespace HDG_WE
     FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(this->data, 0, 0, 0);
     FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(this->data, 0, 0, dim);
 
-    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    const std::vector<unsigned int> &cells = cluster_manager.get_evaluate_cells();
+    for (unsigned int i=0; i<cells.size(); ++i)
       {
-        if (cluster_manager.is_evaluate_cell(cell))
+        const unsigned int cell = cells[i];
+        if (cell>=cell_range.first && cell<cell_range.second)
           {
             this->evaluate_cell(velocity,pressure,src,cell);
             velocity.set_dof_values(dst);
@@ -1674,24 +2422,487 @@ namespace HDG_WE
                                          const LinearAlgebra::distributed::Vector<value_type>  &src,
                                          const std::pair<unsigned int,unsigned int>    &cell_range) const
   {
-    for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+    const std::vector<unsigned int> &cells = cluster_manager.get_evaluate_cells();
+    for (unsigned int i=0; i<cells.size(); ++i)
       {
-        if (cluster_manager.is_evaluate_cell(cell))
+        const unsigned int cell = cells[i];
+        if (cell>=cell_range.first && cell<cell_range.second)
           {
-            this->mass_matrix_data->phi[0].reinit(cell);
-            this->mass_matrix_data->phi[0].read_dof_values(src);
+            this->mass_matrix_data->get().phi[0].reinit(cell);
+            this->mass_matrix_data->get().phi[0].read_dof_values(src);
 
-            this->mass_matrix_data->inverse.fill_inverse_JxW_values(this->mass_matrix_data->coefficients);
-            this->mass_matrix_data->inverse.apply(this->mass_matrix_data->coefficients, dim+1,
-                                                  this->mass_matrix_data->phi[0].begin_dof_values(),
-                                                  this->mass_matrix_data->phi[0].begin_dof_values());
+            this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
+            this->mass_matrix_data->get().apply(this->mass_matrix_data->get().phi[0].begin_dof_values(),
+                                                this->mass_matrix_data->get().phi[0].begin_dof_values());
 
-            this->mass_matrix_data->phi[0].set_dof_values(dst);
+            this->mass_matrix_data->get().phi[0].set_dof_values(dst);
           }
       }
   }
 
 
+  template<int dim, int fe_degree>
+  WaveEquationOperationRKLTS<dim,fe_degree>::
+  WaveEquationOperationRKLTS(TimeControl &time_control_in, Parameters &parameters_in)
+    : WaveEquationOperation<dim,fe_degree>(time_control_in,parameters_in)
+  {}
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  setup(const MappingQGeneric<dim>                 &mapping,
+        const std::vector<const DoFHandler<dim> *> &dof_handlers,
+        const std::vector<Material>                &mats,
+        const std::vector<unsigned int> &)
+  {
+    // the multirate scheme subcycles the faster cluster an integer number of
+    // times within each step of the slower one
+    std::vector<unsigned int> new_vec_categors;
+    cluster_manager.enable_nested_time_steps();
+    cluster_manager.set_repartition_threshold(this->parameters.load_imbalance_threshold);
+    cluster_manager.propose_cluster_categorization(new_vec_categors,
+                                                   dof_handlers[0]->get_triangulation(),
+                                                   dof_handlers,
+                                                   this->parameters.max_n_clusters,
+                                                   this->parameters.max_diff_clusters,
+                                                   this->parameters.cfl_number);
+    WaveEquationOperation<dim,fe_degree>::setup(mapping,dof_handlers,mats,new_vec_categors);
+
+    // initialize the registers of the scheme
+    this->data.initialize_dof_vector(cluster_manager.stage_accumulator);
+    cluster_manager.stage_derivative.reinit(cluster_manager.stage_accumulator);
+    cluster_manager.start_derivative.reinit(cluster_manager.stage_accumulator);
+
+    cluster_manager.setup(*this);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  std::string WaveEquationOperationRKLTS<dim,fe_degree>::Name()
+  {
+    return "RKLTS";
+  }
+
+  template<int dim, int fe_degree>
+  unsigned int WaveEquationOperationRKLTS<dim,fe_degree>::cluster_id(unsigned int cell) const
+  {
+    return cluster_manager.cell_cluster_ids[cell];
+  }
+
+  template<int dim, int fe_degree>
+  typename WaveEquationOperation<dim,fe_degree>::value_type WaveEquationOperationRKLTS<dim,fe_degree>::time_step(unsigned int cell) const
+  {
+    return cluster_manager.get_cell_time_step(cell);
+  }
+
+  template<int dim, int fe_degree>
+  double WaveEquationOperationRKLTS<dim,fe_degree>::load_imbalance() const
+  {
+    return cluster_manager.load_imbalance();
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  apply_multirate_rk(const std::vector<double>                      &stage_factors,
+                     const std::vector<double>                      &weights,
+                     LinearAlgebra::distributed::Vector<value_type> &state) const
+  {
+    cluster_manager.perform_multirate_time_step(*this,stage_factors,weights,state);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  evaluate_selected_cells(const LinearAlgebra::distributed::Vector<value_type> &src,
+                          LinearAlgebra::distributed::Vector<value_type>       &dst) const
+  {
+    Timer timer;
+    local_apply_lts_domain(this->data, dst, src,
+                           std::make_pair(0U,this->data.n_macro_cells()));
+
+    // data exchange of MatrixFree::loop, restricted to the ghost cells of the
+    // clusters next to the evaluated one
+    const bool ghosts_set = src.has_ghost_elements();
+    if (!ghosts_set)
+      cluster_manager.update_ghost_values(src);
+    local_apply_lts_face(this->data, dst, src, cluster_manager.get_inner_face_range());
+    local_apply_lts_boundary_face(this->data, dst, src, cluster_manager.get_boundary_face_range());
+    if (!ghosts_set)
+      src.zero_out_ghosts();
+    cluster_manager.compress_add(dst);
+    this->computing_times[0] += timer.wall_time();
+
+    timer.restart();
+    local_apply_lts_mass_matrix(this->data, dst, dst,
+                                std::make_pair(0U,this->data.n_macro_cells()));
+    this->computing_times[1] += timer.wall_time();
+    this->computing_times[2] += 1.;
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  update_stage(const std::vector<unsigned int>                      &cells,
+               const LinearAlgebra::distributed::Vector<value_type> &derivative,
+               const value_type                                      stage_factor,
+               const value_type                                      weight,
+               const bool                                            is_first,
+               const bool                                            is_last,
+               LinearAlgebra::distributed::Vector<value_type>       &state,
+               LinearAlgebra::distributed::Vector<value_type>       &accumulator) const
+  {
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    const VectorizedArray<value_type> factor = make_vectorized_array(stage_factor);
+    const VectorizedArray<value_type> weight_vec = make_vectorized_array(weight);
+
+    // the cells are disjoint, so distribute them over the threads with their
+    // own scratch data
+    parallel::apply_to_subranges(0U, static_cast<unsigned int>(cells.size()),
+                                 [&](const unsigned int begin, const unsigned int end)
+    {
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[0];
+      FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi_base = this->mass_matrix_data->get().phi[1];
+      for (unsigned int i=begin; i<end; ++i)
+        {
+          phi.reinit(cells[i]);
+          phi.read_dof_values(derivative);
+          phi_base.reinit(cells[i]);
+          phi_base.read_dof_values(is_first ? state : accumulator);
+          VectorizedArray<value_type> *k = phi.begin_dof_values();
+          VectorizedArray<value_type> *base = phi_base.begin_dof_values();
+          if (is_last)
+            {
+              for (unsigned int j=0; j<dofs_per_cell; ++j)
+                k[j] = base[j] + weight_vec * k[j];
+              phi.set_dof_values(state);
+            }
+          else
+            {
+              for (unsigned int j=0; j<dofs_per_cell; ++j)
+                {
+                  const VectorizedArray<value_type> update = k[j];
+                  k[j] = base[j] + factor * update;
+                  base[j] += weight_vec * update;
+                }
+              phi.set_dof_values(state);
+              phi_base.set_dof_values(accumulator);
+            }
+        }
+    }, this->cell_grain_size);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  copy_cells_to_buffer(const std::vector<unsigned int>                          &cells,
+                       const LinearAlgebra::distributed::Vector<value_type>     &src,
+                       AlignedVector<VectorizedArray<value_type> >              &buffer) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        phi.reinit(cells[i]);
+        phi.read_dof_values(src);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          buffer.push_back(phi.begin_dof_values()[j]);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  copy_buffer_to_cells(const std::vector<unsigned int>                          &cells,
+                       const AlignedVector<VectorizedArray<value_type> >        &buffer,
+                       LinearAlgebra::distributed::Vector<value_type>           &dst) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    AssertDimension(buffer.size(), cells.size()*dofs_per_cell);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        phi.reinit(cells[i]);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          phi.begin_dof_values()[j] = buffer[i*dofs_per_cell+j];
+        phi.set_dof_values(dst);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  combine_buffers_to_cells(const std::vector<unsigned int>                   &cells,
+                           const AlignedVector<VectorizedArray<value_type> > &buffer0,
+                           const value_type                                   factor0,
+                           const AlignedVector<VectorizedArray<value_type> > &buffer1,
+                           const value_type                                   factor1,
+                           LinearAlgebra::distributed::Vector<value_type>    &dst) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> &phi = this->mass_matrix_data->get().phi[1];
+    constexpr unsigned int dofs_per_cell = (dim+1)*Utilities::pow(fe_degree+1,dim);
+    AssertDimension(buffer0.size(), cells.size()*dofs_per_cell);
+    AssertDimension(buffer1.size(), cells.size()*dofs_per_cell);
+    const VectorizedArray<value_type> f0 = make_vectorized_array(factor0);
+    const VectorizedArray<value_type> f1 = make_vectorized_array(factor1);
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        phi.reinit(cells[i]);
+        for (unsigned int j=0; j<dofs_per_cell; ++j)
+          phi.begin_dof_values()[j] = f0*buffer0[i*dofs_per_cell+j] + f1*buffer1[i*dofs_per_cell+j];
+        phi.set_dof_values(dst);
+      }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim, fe_degree>::
+  local_apply_lts_domain(const MatrixFree<dim,value_type> &,
+                         LinearAlgebra::distributed::Vector<value_type>       &dst,
+                         const LinearAlgebra::distributed::Vector<value_type> &src,
+                         const std::pair<unsigned int,unsigned int>           &cell_range) const
+  {
+    FEEvaluation<dim,fe_degree,fe_degree+1,dim,value_type> velocity(this->data, 0, 0, 0);
+    FEEvaluation<dim,fe_degree,fe_degree+1,1,value_type> pressure(this->data, 0, 0, dim);
+
+    const std::vector<unsigned int> &cells = cluster_manager.get_evaluate_cells();
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        const unsigned int cell = cells[i];
+        if (cell>=cell_range.first && cell<cell_range.second)
+          {
+            this->evaluate_cell(velocity,pressure,src,cell);
+            velocity.set_dof_values(dst);
+            pressure.set_dof_values(dst);
+          }
+      }
+  }
+
+
+
+  template <int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  local_apply_lts_face(const MatrixFree<dim,value_type> &,
+                       LinearAlgebra::distributed::Vector<value_type>       &dst,
+                       const LinearAlgebra::distributed::Vector<value_type> &src,
+                       const std::pair<unsigned int,unsigned int>           &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi(this->data, true, 0, 0, 0);
+    FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi_neighbor(this->data, false, 0, 0, 0);
+
+    for (unsigned int face=face_range.first; face<face_range.second; face++)
+      if (cluster_manager.is_evaluate_face(face))
+        {
+          this->evaluate_inner_face(phi, phi_neighbor, src, face, 1.0, nullptr);
+
+          // write only to the cells of the evaluated cluster
+          phi.distribute_local_to_global(dst, 0, cluster_manager.get_phi_to_dst(face));
+          phi_neighbor.distribute_local_to_global(dst, 0, cluster_manager.get_phi_neighbor_to_dst(face));
+        }
+  }
+
+
+
+  template <int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  local_apply_lts_boundary_face(const MatrixFree<dim,value_type> &,
+                                LinearAlgebra::distributed::Vector<value_type>       &dst,
+                                const LinearAlgebra::distributed::Vector<value_type> &src,
+                                const std::pair<unsigned int,unsigned int>           &face_range) const
+  {
+    FEFaceEvaluation<dim,fe_degree,fe_degree+1,dim+1,value_type> phi(this->data, true, 0, 0, 0);
+
+    for (unsigned int face=face_range.first; face<face_range.second; face++)
+      if (cluster_manager.is_evaluate_face(face))
+        {
+          this->evaluate_boundary_face(phi, src, face, 1.0, nullptr);
+          phi.distribute_local_to_global(dst, 0, cluster_manager.get_phi_to_dst(face));
+        }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationRKLTS<dim,fe_degree>::
+  local_apply_lts_mass_matrix(const MatrixFree<dim,value_type> &,
+                              LinearAlgebra::distributed::Vector<value_type>       &dst,
+                              const LinearAlgebra::distributed::Vector<value_type> &src,
+                              const std::pair<unsigned int,unsigned int>           &cell_range) const
+  {
+    const std::vector<unsigned int> &cells = cluster_manager.get_evaluate_cells();
+    for (unsigned int i=0; i<cells.size(); ++i)
+      {
+        const unsigned int cell = cells[i];
+        if (cell>=cell_range.first && cell<cell_range.second)
+          {
+            this->mass_matrix_data->get().phi[0].reinit(cell);
+            this->mass_matrix_data->get().phi[0].read_dof_values(src);
+
+            this->mass_matrix_data->get().inverse.fill_inverse_JxW_values(this->mass_matrix_data->get().coefficients);
+            this->mass_matrix_data->get().apply(this->mass_matrix_data->get().phi[0].begin_dof_values(),
+                                                this->mass_matrix_data->get().phi[0].begin_dof_values());
+
+            this->mass_matrix_data->get().phi[0].set_dof_values(dst);
+          }
+      }
+  }
+
+
+  namespace
+  {
+    // copy the locally owned part of a vector into a vector of different
+    // precision with the same parallel layout
+    template <typename Number, typename Number2>
+    void copy_locally_owned(const LinearAlgebra::distributed::Vector<Number2> &src,
+                            LinearAlgebra::distributed::Vector<Number>        &dst)
+    {
+      AssertDimension(src.local_size(), dst.local_size());
+      for (unsigned int i=0; i<src.local_size(); ++i)
+        dst.local_element(i) = src.local_element(i);
+    }
+  }
+
+
+
+  template<int dim, int fe_degree>
+  WaveEquationOperationMixed<dim,fe_degree>::
+  WaveEquationOperationMixed(TimeControl &time_control_in, Parameters &parameters_in)
+    :
+    operation(time_control_in, parameters_in)
+  {}
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::
+  setup(const MappingQGeneric<dim>                 &mapping,
+        const std::vector<const DoFHandler<dim> *> &dof_handlers,
+        const std::vector<Material>                &mats,
+        const std::vector<unsigned int>            &vectorization_categories)
+  {
+    operation.setup(mapping,dof_handlers,mats,vectorization_categories);
+
+    // The DoFs are already renumbered by the single precision operator, the
+    // double precision object only provides the vector layout and cell
+    // iterators, so no mapping data is computed
+    AffineConstraints<value_type> dummy;
+    dummy.close();
+    std::vector<const AffineConstraints<value_type> *> constraints(dof_handlers.size(),&dummy);
+    typename MatrixFree<dim,value_type>::AdditionalData additional_data;
+    additional_data.tasks_parallel_scheme =
+      MatrixFree<dim,value_type>::AdditionalData::partition_partition;
+    additional_data.hold_all_faces_to_owned_cells = true;
+    additional_data.initialize_mapping = false;
+    data.reinit(mapping,dof_handlers,constraints,QGauss<1>(fe_degree+1),additional_data);
+
+    operation.get_matrix_free().initialize_dof_vector(src_number);
+    dst_number.reinit(src_number);
+    operation.get_matrix_free().initialize_dof_vector(post_number, 1);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  std::string WaveEquationOperationMixed<dim,fe_degree>::Name()
+  {
+    return operation.Name();
+  }
+
+  template<int dim, int fe_degree>
+  const MatrixFree<dim,typename WaveEquationOperationBase<dim>::value_type> &WaveEquationOperationMixed<dim,fe_degree>::get_matrix_free() const
+  {
+    return data;
+  }
+
+  template<int dim, int fe_degree>
+  TimeControl &WaveEquationOperationMixed<dim,fe_degree>::get_time_control() const
+  {
+    return operation.get_time_control();
+  }
+
+  template<int dim, int fe_degree>
+  unsigned int WaveEquationOperationMixed<dim,fe_degree>::cluster_id(unsigned int) const
+  {
+    // no local time stepping in mixed precision. The cell batch index refers
+    // to the double MatrixFree object, whose batches differ from the ones of
+    // the float operator, so it must not be passed on to the latter
+    return -1;
+  }
+
+  template<int dim, int fe_degree>
+  typename WaveEquationOperationBase<dim>::value_type WaveEquationOperationMixed<dim,fe_degree>::time_step(unsigned int ) const
+  {
+    return operation.get_time_control().get_time_step();
+  }
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::apply_ader (const LinearAlgebra::distributed::Vector<value_type> &,
+                                                              LinearAlgebra::distributed::Vector<value_type> &) const
+  {
+    AssertThrow(false,ExcNotImplemented());
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::
+  apply(const LinearAlgebra::distributed::Vector<value_type>  &src,
+        LinearAlgebra::distributed::Vector<value_type>        &dst) const
+  {
+    copy_locally_owned(src, src_number);
+    operation.apply(src_number, dst_number);
+    copy_locally_owned(dst_number, dst);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::
+  project_initial_field(LinearAlgebra::distributed::Vector<value_type> &solution,
+                        const Function<dim>                            &function) const
+  {
+    operation.project_initial_field(dst_number, function);
+    copy_locally_owned(dst_number, solution);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::
+  compute_post_pressure(const LinearAlgebra::distributed::Vector<value_type> &solution,
+                        LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
+                        LinearAlgebra::distributed::Vector<value_type>       &post_pressure_vector) const
+  {
+    copy_locally_owned(solution, src_number);
+    operation.compute_post_pressure(src_number, dst_number, post_number);
+    copy_locally_owned(dst_number, tmp_vector);
+    copy_locally_owned(post_number, post_pressure_vector);
+  }
+
+
+
+  template<int dim, int fe_degree>
+  void WaveEquationOperationMixed<dim,fe_degree>::
+  estimate_error(const LinearAlgebra::distributed::Vector<value_type> &solution,
+                 LinearAlgebra::distributed::Vector<value_type>       &tmp_vector,
+                 Vector<double>                                       &error_estimate) const
+  {
+    copy_locally_owned(solution, src_number);
+    operation.estimate_error(src_number, dst_number, error_estimate);
+    copy_locally_owned(dst_number, tmp_vector);
+  }
+
+
+
   // explicit instaniation for all operators for space dimensions 2,3 and polynomial degrees 1,...,12
   template class WaveEquationOperation<2,1>;
   template class WaveEquationOperation<3,1>;
@@ -1699,8 +2910,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,1>;
   template class WaveEquationOperationADERLTS<2,1>;
   template class WaveEquationOperationADERLTS<3,1>;
+  template class WaveEquationOperationRKLTS<2,1>;
+  template class WaveEquationOperationRKLTS<3,1>;
   template class WaveEquationOperationADERADCONFULL<2,1>;
   template class WaveEquationOperationADERADCONFULL<3,1>;
+  template class WaveEquationOperation<2,1,float>;
+  template class WaveEquationOperation<3,1,float>;
+  template class WaveEquationOperationMixed<2,1>;
+  template class WaveEquationOperationMixed<3,1>;
 
   template class WaveEquationOperation<2,2>;
   template class WaveEquationOperation<3,2>;
@@ -1708,8 +2925,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,2>;
   template class WaveEquationOperationADERLTS<2,2>;
   template class WaveEquationOperationADERLTS<3,2>;
+  template class WaveEquationOperationRKLTS<2,2>;
+  template class WaveEquationOperationRKLTS<3,2>;
   template class WaveEquationOperationADERADCONFULL<2,2>;
   template class WaveEquationOperationADERADCONFULL<3,2>;
+  template class WaveEquationOperation<2,2,float>;
+  template class WaveEquationOperation<3,2,float>;
+  template class WaveEquationOperationMixed<2,2>;
+  template class WaveEquationOperationMixed<3,2>;
 
   template class WaveEquationOperation<2,3>;
   template class WaveEquationOperation<3,3>;
@@ -1717,8 +2940,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,3>;
   template class WaveEquationOperationADERLTS<2,3>;
   template class WaveEquationOperationADERLTS<3,3>;
+  template class WaveEquationOperationRKLTS<2,3>;
+  template class WaveEquationOperationRKLTS<3,3>;
   template class WaveEquationOperationADERADCONFULL<2,3>;
   template class WaveEquationOperationADERADCONFULL<3,3>;
+  template class WaveEquationOperation<2,3,float>;
+  template class WaveEquationOperation<3,3,float>;
+  template class WaveEquationOperationMixed<2,3>;
+  template class WaveEquationOperationMixed<3,3>;
 
   template class WaveEquationOperation<2,4>;
   template class WaveEquationOperation<3,4>;
@@ -1726,8 +2955,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,4>;
   template class WaveEquationOperationADERLTS<2,4>;
   template class WaveEquationOperationADERLTS<3,4>;
+  template class WaveEquationOperationRKLTS<2,4>;
+  template class WaveEquationOperationRKLTS<3,4>;
   template class WaveEquationOperationADERADCONFULL<2,4>;
   template class WaveEquationOperationADERADCONFULL<3,4>;
+  template class WaveEquationOperation<2,4,float>;
+  template class WaveEquationOperation<3,4,float>;
+  template class WaveEquationOperationMixed<2,4>;
+  template class WaveEquationOperationMixed<3,4>;
 
   template class WaveEquationOperation<2,5>;
   template class WaveEquationOperation<3,5>;
@@ -1735,8 +2970,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,5>;
   template class WaveEquationOperationADERLTS<2,5>;
   template class WaveEquationOperationADERLTS<3,5>;
+  template class WaveEquationOperationRKLTS<2,5>;
+  template class WaveEquationOperationRKLTS<3,5>;
   template class WaveEquationOperationADERADCONFULL<2,5>;
   template class WaveEquationOperationADERADCONFULL<3,5>;
+  template class WaveEquationOperation<2,5,float>;
+  template class WaveEquationOperation<3,5,float>;
+  template class WaveEquationOperationMixed<2,5>;
+  template class WaveEquationOperationMixed<3,5>;
 
   template class WaveEquationOperation<2,6>;
   template class WaveEquationOperation<3,6>;
@@ -1744,8 +2985,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,6>;
   template class WaveEquationOperationADERLTS<2,6>;
   template class WaveEquationOperationADERLTS<3,6>;
+  template class WaveEquationOperationRKLTS<2,6>;
+  template class WaveEquationOperationRKLTS<3,6>;
   template class WaveEquationOperationADERADCONFULL<2,6>;
   template class WaveEquationOperationADERADCONFULL<3,6>;
+  template class WaveEquationOperation<2,6,float>;
+  template class WaveEquationOperation<3,6,float>;
+  template class WaveEquationOperationMixed<2,6>;
+  template class WaveEquationOperationMixed<3,6>;
 
   template class WaveEquationOperation<2,7>;
   template class WaveEquationOperation<3,7>;
@@ -1753,8 +3000,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,7>;
   template class WaveEquationOperationADERLTS<2,7>;
   template class WaveEquationOperationADERLTS<3,7>;
+  template class WaveEquationOperationRKLTS<2,7>;
+  template class WaveEquationOperationRKLTS<3,7>;
   template class WaveEquationOperationADERADCONFULL<2,7>;
   template class WaveEquationOperationADERADCONFULL<3,7>;
+  template class WaveEquationOperation<2,7,float>;
+  template class WaveEquationOperation<3,7,float>;
+  template class WaveEquationOperationMixed<2,7>;
+  template class WaveEquationOperationMixed<3,7>;
 
   template class WaveEquationOperation<2,8>;
   template class WaveEquationOperation<3,8>;
@@ -1762,8 +3015,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,8>;
   template class WaveEquationOperationADERLTS<2,8>;
   template class WaveEquationOperationADERLTS<3,8>;
+  template class WaveEquationOperationRKLTS<2,8>;
+  template class WaveEquationOperationRKLTS<3,8>;
   template class WaveEquationOperationADERADCONFULL<2,8>;
   template class WaveEquationOperationADERADCONFULL<3,8>;
+  template class WaveEquationOperation<2,8,float>;
+  template class WaveEquationOperation<3,8,float>;
+  template class WaveEquationOperationMixed<2,8>;
+  template class WaveEquationOperationMixed<3,8>;
 
   template class WaveEquationOperation<2,9>;
   template class WaveEquationOperation<3,9>;
@@ -1771,8 +3030,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,9>;
   template class WaveEquationOperationADERLTS<2,9>;
   template class WaveEquationOperationADERLTS<3,9>;
+  template class WaveEquationOperationRKLTS<2,9>;
+  template class WaveEquationOperationRKLTS<3,9>;
   template class WaveEquationOperationADERADCONFULL<2,9>;
   template class WaveEquationOperationADERADCONFULL<3,9>;
+  template class WaveEquationOperation<2,9,float>;
+  template class WaveEquationOperation<3,9,float>;
+  template class WaveEquationOperationMixed<2,9>;
+  template class WaveEquationOperationMixed<3,9>;
 
   template class WaveEquationOperation<2,10>;
   template class WaveEquationOperation<3,10>;
@@ -1780,8 +3045,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,10>;
   template class WaveEquationOperationADERLTS<2,10>;
   template class WaveEquationOperationADERLTS<3,10>;
+  template class WaveEquationOperationRKLTS<2,10>;
+  template class WaveEquationOperationRKLTS<3,10>;
   template class WaveEquationOperationADERADCONFULL<2,10>;
   template class WaveEquationOperationADERADCONFULL<3,10>;
+  template class WaveEquationOperation<2,10,float>;
+  template class WaveEquationOperation<3,10,float>;
+  template class WaveEquationOperationMixed<2,10>;
+  template class WaveEquationOperationMixed<3,10>;
 
   template class WaveEquationOperation<2,11>;
   template class WaveEquationOperation<3,11>;
@@ -1789,8 +3060,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,11>;
   template class WaveEquationOperationADERLTS<2,11>;
   template class WaveEquationOperationADERLTS<3,11>;
+  template class WaveEquationOperationRKLTS<2,11>;
+  template class WaveEquationOperationRKLTS<3,11>;
   template class WaveEquationOperationADERADCONFULL<2,11>;
   template class WaveEquationOperationADERADCONFULL<3,11>;
+  template class WaveEquationOperation<2,11,float>;
+  template class WaveEquationOperation<3,11,float>;
+  template class WaveEquationOperationMixed<2,11>;
+  template class WaveEquationOperationMixed<3,11>;
 
   template class WaveEquationOperation<2,12>;
   template class WaveEquationOperation<3,12>;
@@ -1798,8 +3075,14 @@ namespace HDG_WE
   template class WaveEquationOperationADER<3,12>;
   template class WaveEquationOperationADERLTS<2,12>;
   template class WaveEquationOperationADERLTS<3,12>;
+  template class WaveEquationOperationRKLTS<2,12>;
+  template class WaveEquationOperationRKLTS<3,12>;
   template class WaveEquationOperationADERADCONFULL<2,12>;
   template class WaveEquationOperationADERADCONFULL<3,12>;
+  template class WaveEquationOperation<2,12,float>;
+  template class WaveEquationOperation<3,12,float>;
+  template class WaveEquationOperationMixed<2,12>;
+  template class WaveEquationOperationMixed<3,12>;
 
 }
 
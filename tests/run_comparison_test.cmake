@@ -0,0 +1,104 @@
+# --------------------------------------------------------------------------
+#
+# Copyright (C) 2018 by the ExWave authors
+#
+# This file is part of the ExWave library.
+#
+# The ExWave library is free software; you can use it, redistribute it,
+# and/or modify it under the terms of the GNU Lesser General Public License
+# as published by the Free Software Foundation; either version 2.1 of the
+# License, or (at your option) any later version.  The full text of the
+# license can be found in the file LICENSE at the top level of the ExWave
+# distribution.
+#
+# --------------------------------------------------------------------------
+
+# Run the parameter file PRM_FILE as given and with the parameter named in
+# its line
+#    '# compare: fused_inverse_mass = false'
+# set to the value given there, and check that both runs print the same
+# errors. This tests an alternative code path on setups that have no stored
+# reference output. A line
+#    '# tolerance: 1e-4'
+# accepts numbers in the error lines that differ by this relative amount,
+# for code paths that change the round-off.
+
+FILE(READ ${PRM_FILE} _prm)
+STRING(REGEX MATCH "# *compare: *([A-Za-z_]+) *= *([A-Za-z0-9_.]+)" _match "${_prm}")
+IF("${_match}" STREQUAL "")
+  MESSAGE(FATAL_ERROR "*** ${TESTNAME}: no '# compare:' line found ***")
+ENDIF()
+SET(_parameter ${CMAKE_MATCH_1})
+SET(_value ${CMAKE_MATCH_2})
+STRING(REGEX MATCH "# *tolerance: *([0-9.e+-]+)" _match "${_prm}")
+SET(_tolerance ${CMAKE_MATCH_1})
+STRING(REGEX REPLACE "set ${_parameter} *= *[A-Za-z0-9_.]+"
+       "set ${_parameter} = ${_value}" _reference_prm "${_prm}")
+IF("${_reference_prm}" STREQUAL "${_prm}")
+  MESSAGE(FATAL_ERROR "*** ${TESTNAME}: parameter ${_parameter} not set in the test ***")
+ENDIF()
+
+FILE(MAKE_DIRECTORY ${OUTPUT_DIR}/output)
+CONFIGURE_FILE(${PRM_FILE} ${OUTPUT_DIR}/test.prm COPYONLY)
+FILE(WRITE ${OUTPUT_DIR}/reference.prm "${_reference_prm}")
+
+SET(_errors)
+FOREACH(_run test reference)
+  EXECUTE_PROCESS(COMMAND mpirun -np ${MPI_COUNT} ${BINARY_DIR}/explicit_wave
+                          ${OUTPUT_DIR}/${_run}.prm
+    WORKING_DIRECTORY ${OUTPUT_DIR}
+    RESULT_VARIABLE _result_code
+    OUTPUT_VARIABLE _output
+    )
+  FILE(WRITE ${OUTPUT_DIR}/screen-output-${_run} "${_output}")
+  IF(NOT "${_result_code}" STREQUAL "0")
+    MESSAGE(FATAL_ERROR "*** ${TESTNAME}: the ${_run} run failed ***\n${_output}")
+  ENDIF()
+
+  # the same lines as in the comparison against stored output
+  STRING(REGEX MATCHALL "[^\n]*error[^\n]*" _lines "${_output}")
+  IF("${_lines}" STREQUAL "")
+    MESSAGE(FATAL_ERROR "*** ${TESTNAME}: no error found in the ${_run} run ***")
+  ENDIF()
+  SET(_errors_${_run} "${_lines}")
+ENDFOREACH()
+
+STRING(REPLACE ";" "\n" _errors_test "${_errors_test}")
+STRING(REPLACE ";" "\n" _errors_reference "${_errors_reference}")
+IF("${_tolerance}" STREQUAL "")
+  STRING(COMPARE NOTEQUAL "${_errors_test}" "${_errors_reference}" _differ)
+ELSE()
+  # CMake has no floating point arithmetic, so the numbers are compared by
+  # awk, field by field
+  FILE(WRITE ${OUTPUT_DIR}/errors-test "${_errors_test}\n")
+  FILE(WRITE ${OUTPUT_DIR}/errors-reference "${_errors_reference}\n")
+  FILE(WRITE ${OUTPUT_DIR}/compare.awk
+"NR==FNR { ref[FNR] = $0; n = FNR; next }
+{
+  m = split($0, a, /[ ,:]+/); split(ref[FNR], b, /[ ,:]+/);
+  for (i=1; i<=m; ++i)
+    if (a[i] ~ /^[0-9.]+e[-+][0-9]+$/) {
+      d = a[i] - b[i]; if (d < 0) d = -d;
+      s = a[i] > b[i] ? a[i] : b[i];
+      if (d > tol*s) bad = 1;
+    }
+    else if (a[i] != b[i]) bad = 1;
+}
+END { exit (bad || FNR != n) }
+")
+  EXECUTE_PROCESS(COMMAND awk -v tol=${_tolerance} -f ${OUTPUT_DIR}/compare.awk
+    ${OUTPUT_DIR}/errors-reference ${OUTPUT_DIR}/errors-test
+    RESULT_VARIABLE _differ
+    )
+  IF("${_differ}" STREQUAL "0")
+    SET(_differ FALSE)
+  ELSE()
+    SET(_differ TRUE)
+  ENDIF()
+ENDIF()
+
+IF(_differ)
+  MESSAGE(FATAL_ERROR "*** ${TESTNAME}: errors differ from the run with "
+    "${_parameter} = ${_value} ***\n${_errors_test}\n--- reference:\n${_errors_reference}")
+ENDIF()
+MESSAGE("${TESTNAME}: success.")
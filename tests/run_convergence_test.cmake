@@ -0,0 +1,70 @@
+# --------------------------------------------------------------------------
+#
+# Copyright (C) 2018 by the ExWave authors
+#
+# This file is part of the ExWave library.
+#
+# The ExWave library is free software; you can use it, redistribute it,
+# and/or modify it under the terms of the GNU Lesser General Public License
+# as published by the Free Software Foundation; either version 2.1 of the
+# License, or (at your option) any later version.  The full text of the
+# license can be found in the file LICENSE at the top level of the ExWave
+# distribution.
+#
+# --------------------------------------------------------------------------
+
+# Run the parameter file PRM_FILE as given and with one more global
+# refinement, and check that the pressure error at the final time decreases
+# at least with the rate MIN_RATE. The time step follows the mesh size
+# through the CFL condition, so the rate covers space and time.
+
+FILE(READ ${PRM_FILE} _prm)
+STRING(REGEX MATCH "set n_refinements *= *([0-9]+)" _match "${_prm}")
+SET(_coarse_refinements ${CMAKE_MATCH_1})
+MATH(EXPR _fine_refinements "${_coarse_refinements} + 1")
+STRING(REGEX REPLACE "set n_refinements *= *[0-9]+"
+       "set n_refinements = ${_fine_refinements}" _fine_prm "${_prm}")
+
+FILE(MAKE_DIRECTORY ${OUTPUT_DIR}/output)
+CONFIGURE_FILE(${PRM_FILE} ${OUTPUT_DIR}/coarse.prm COPYONLY)
+FILE(WRITE ${OUTPUT_DIR}/fine.prm "${_fine_prm}")
+
+SET(_errors)
+FOREACH(_run coarse fine)
+  EXECUTE_PROCESS(COMMAND mpirun -np ${MPI_COUNT} ${BINARY_DIR}/explicit_wave
+                          ${OUTPUT_DIR}/${_run}.prm
+    WORKING_DIRECTORY ${OUTPUT_DIR}
+    RESULT_VARIABLE _result_code
+    OUTPUT_VARIABLE _output
+    )
+  FILE(WRITE ${OUTPUT_DIR}/screen-output-${_run} "${_output}")
+  IF(NOT "${_result_code}" STREQUAL "0")
+    MESSAGE(FATAL_ERROR "*** ${TESTNAME}: the ${_run} run failed ***\n${_output}")
+  ENDIF()
+
+  # the last error printed is the one at the final time
+  STRING(REGEX MATCHALL "error p: *[0-9.]+e[-+][0-9]+" _lines "${_output}")
+  IF("${_lines}" STREQUAL "")
+    MESSAGE(FATAL_ERROR "*** ${TESTNAME}: no error found in the ${_run} run ***")
+  ENDIF()
+  LIST(GET _lines -1 _last_line)
+  STRING(REGEX REPLACE "error p: *" "" _error ${_last_line})
+  LIST(APPEND _errors ${_error})
+ENDFOREACH()
+
+LIST(GET _errors 0 _coarse_error)
+LIST(GET _errors 1 _fine_error)
+
+# CMake has no floating point arithmetic, so the rate is evaluated by awk
+EXECUTE_PROCESS(COMMAND awk "BEGIN { printf \"%.2f\", log(${_coarse_error}/${_fine_error})/log(2.) }"
+  OUTPUT_VARIABLE _rate
+  )
+EXECUTE_PROCESS(COMMAND awk "BEGIN { exit !(${_rate} >= ${MIN_RATE}) }"
+  RESULT_VARIABLE _rate_too_low
+  )
+
+MESSAGE("${TESTNAME}: errors ${_coarse_error} ${_fine_error}, rate ${_rate}")
+IF(NOT "${_rate_too_low}" STREQUAL "0")
+  MESSAGE(FATAL_ERROR "*** ${TESTNAME}: convergence rate ${_rate} below ${MIN_RATE} ***")
+ENDIF()
+MESSAGE("${TESTNAME}: success.")